@@ -0,0 +1,41 @@
+#include "starkit_utils/timing/bench.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace starkit_utils;
+
+/**
+ * Compare two csv runs written by bench::writeCSV
+ *
+ * Usage: starkit_utils_bench_compare before.csv after.csv [threshold]
+ *
+ * Exits with 1 if a significant regression is found, 2 on errors
+ */
+int main(int argc, char** argv)
+{
+  if (argc != 3 && argc != 4)
+  {
+    std::cerr << "Usage: " << argv[0] << " before.csv after.csv [threshold]" << std::endl;
+    return 2;
+  }
+  std::ifstream before(argv[1]);
+  std::ifstream after(argv[2]);
+  if (!before || !after)
+  {
+    std::cerr << "Failed to open " << (before ? argv[2] : argv[1]) << std::endl;
+    return 2;
+  }
+  try
+  {
+    double threshold = argc == 4 ? std::stod(argv[3]) : 0.05;
+    int nbRegressions = bench::printComparisons(std::cout, bench::compare(before, after, threshold));
+    return nbRegressions > 0 ? 1 : 0;
+  }
+  catch (const std::exception& exc)
+  {
+    std::cerr << exc.what() << std::endl;
+    return 2;
+  }
+}
@@ -0,0 +1,319 @@
+#include "starkit_utils/history/history.h"
+
+#include <json/json.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace starkit_utils;
+
+/**
+ * History micro benchmarks
+ *
+ * Usage: starkit_utils_bench [--format csv|json] [--output path] [--quick] [--filter substring]
+ */
+
+struct Result
+{
+  std::string name;
+  std::string parameters;
+  uint64_t iterations;
+  double seconds;
+  /**
+   * Optional amount of bytes processed, for throughput benchmarks
+   */
+  double bytes;
+};
+
+struct Options
+{
+  std::string format = "csv";
+  std::string output = "";
+  std::string filter = "";
+  bool quick = false;
+};
+
+static Options options;
+static std::vector<Result> results;
+
+static double now()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Return true if the benchmark matches the filter
+ */
+static bool selected(const std::string& name)
+{
+  return options.filter == "" || name.find(options.filter) != std::string::npos;
+}
+
+static void record(const std::string& name, const std::string& parameters, uint64_t iterations, double seconds,
+                   double bytes = 0.0)
+{
+  results.push_back(Result{ name, parameters, iterations, seconds, bytes });
+  std::cerr << name << " " << parameters << ": " << 1e9 * seconds / iterations << " ns/op" << std::endl;
+}
+
+/**
+ * Start nbReaders threads interpolating in h until stopped
+ */
+class Readers
+{
+public:
+  Readers(History& h, int nbReaders) : _running(true)
+  {
+    for (int i = 0; i < nbReaders; i++)
+    {
+      _threads.push_back(std::thread([this, &h]() {
+        double sum = 0;
+        while (_running)
+        {
+          sum += h.interpolate(h.back().first - 0.5);
+        }
+        // Keep the result alive
+        volatile double sink = sum;
+        (void)sink;
+      }));
+    }
+  }
+
+  ~Readers()
+  {
+    _running = false;
+    for (std::thread& thread : _threads)
+    {
+      thread.join();
+    }
+  }
+
+private:
+  std::atomic<bool> _running;
+  std::vector<std::thread> _threads;
+};
+
+static std::string parameters(bool lockFree, size_t window, int nbReaders)
+{
+  return std::string("mode=") + (lockFree ? "lockfree" : "mutex") + ";window=" + std::to_string(window) +
+         ";readers=" + std::to_string(nbReaders);
+}
+
+/**
+ * Build a history holding window samples (1 sample per ms)
+ */
+static History* buildHistory(bool lockFree, size_t window)
+{
+  History* h = lockFree ? new History(window * 0.001, window + 16) : new History(window * 0.001);
+  for (size_t i = 0; i < window; i++)
+  {
+    h->pushValue(i * 0.001, std::sin(i * 0.001));
+  }
+  return h;
+}
+
+static void benchPushInterpolate()
+{
+  std::vector<size_t> windows = { 10, 1000, 100000, 1000000 };
+  std::vector<int> readers = { 0, 1, 2, 4 };
+  if (options.quick)
+  {
+    windows = { 10, 1000 };
+    readers = { 0, 2 };
+  }
+  uint64_t nbOps = options.quick ? 20000 : 1000000;
+  for (bool lockFree : { false, true })
+  {
+    for (size_t window : windows)
+    {
+      for (int nbReaders : readers)
+      {
+        std::string params = parameters(lockFree, window, nbReaders);
+        if (selected("pushValue"))
+        {
+          std::unique_ptr<History> h(buildHistory(lockFree, window));
+          Readers running(*h, nbReaders);
+          double start = now();
+          for (uint64_t i = 0; i < nbOps; i++)
+          {
+            h->pushValue((window + i) * 0.001, i);
+          }
+          record("pushValue", params, nbOps, now() - start);
+        }
+        if (selected("interpolate"))
+        {
+          std::unique_ptr<History> h(buildHistory(lockFree, window));
+          Readers running(*h, nbReaders);
+          double sum = 0;
+          double start = now();
+          for (uint64_t i = 0; i < nbOps; i++)
+          {
+            sum += h->interpolate((i % window) * 0.001 + 0.0005);
+          }
+          record("interpolate", params, nbOps, now() - start);
+          if (std::isnan(sum))
+          {
+            std::cerr << "unexpected nan" << std::endl;
+          }
+        }
+      }
+    }
+  }
+}
+
+static void benchLogs()
+{
+  size_t nbPoints = options.quick ? 10000 : 1000000;
+  std::vector<std::pair<std::string, History::LogFormat>> formats = { { "ascii", History::Ascii },
+                                                                      { "binary", History::Binary },
+                                                                      { "compressed", History::Compressed } };
+  for (const auto& format : formats)
+  {
+    std::string params = "format=" + format.first + ";points=" + std::to_string(nbPoints);
+    // Stopping only keeps the window, so each format dumps a freshly filled history
+    History h(1.0);
+    h.startLogging();
+    for (size_t i = 0; i < nbPoints; i++)
+    {
+      h.pushValue(1.0 + i * 0.001, std::sin(i * 0.001));
+    }
+    std::ostringstream os;
+    double start = now();
+    h.stopLogging(os, format.second);
+    double elapsed = now() - start;
+    std::string log = os.str();
+    if (selected("stopLogging"))
+    {
+      record("stopLogging", params, nbPoints, elapsed, log.size());
+    }
+    if (selected("loadReplay"))
+    {
+      History replay;
+      std::istringstream is(log);
+      start = now();
+      replay.loadReplay(is, format.second != History::Ascii);
+      record("loadReplay", params, nbPoints, now() - start, log.size());
+    }
+  }
+}
+
+static void benchNamedSessions()
+{
+  if (!selected("namedSessions"))
+  {
+    return;
+  }
+  uint64_t nbOps = options.quick ? 10000 : 50000;
+  for (int nbSessions : { 0, 1, 10, 100 })
+  {
+    History h(1.0);
+    for (int i = 0; i < nbSessions; i++)
+    {
+      h.startNamedLog("session_" + std::to_string(i));
+    }
+    double start = now();
+    for (uint64_t i = 0; i < nbOps; i++)
+    {
+      h.pushValue(i * 0.001, i);
+    }
+    record("namedSessions", "sessions=" + std::to_string(nbSessions), nbOps, now() - start);
+  }
+}
+
+static void writeCSV(std::ostream& os)
+{
+  os << "name,parameters,iterations,seconds,ns_per_op,ops_per_sec,mb_per_sec" << std::endl;
+  for (const Result& result : results)
+  {
+    os << result.name << "," << result.parameters << "," << result.iterations << "," << result.seconds << ","
+       << 1e9 * result.seconds / result.iterations << "," << result.iterations / result.seconds << ","
+       << result.bytes / result.seconds / 1e6 << std::endl;
+  }
+}
+
+static void writeJSON(std::ostream& os)
+{
+  Json::Value benchmarks(Json::arrayValue);
+  for (const Result& result : results)
+  {
+    Json::Value value;
+    value["name"] = result.name;
+    value["parameters"] = result.parameters;
+    value["iterations"] = Json::UInt64(result.iterations);
+    value["seconds"] = result.seconds;
+    value["ns_per_op"] = 1e9 * result.seconds / result.iterations;
+    value["ops_per_sec"] = result.iterations / result.seconds;
+    value["mb_per_sec"] = result.bytes / result.seconds / 1e6;
+    benchmarks.append(value);
+  }
+  Json::Value root;
+  root["benchmarks"] = benchmarks;
+  os << Json::StyledWriter().write(root);
+}
+
+int main(int argc, char** argv)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--quick")
+    {
+      options.quick = true;
+    }
+    else if (arg == "--format" && i + 1 < argc)
+    {
+      options.format = argv[++i];
+    }
+    else if (arg == "--output" && i + 1 < argc)
+    {
+      options.output = argv[++i];
+    }
+    else if (arg == "--filter" && i + 1 < argc)
+    {
+      options.filter = argv[++i];
+    }
+    else
+    {
+      std::cerr << "Usage: " << argv[0] << " [--format csv|json] [--output path] [--quick] [--filter substring]"
+                << std::endl;
+      return 1;
+    }
+  }
+  if (options.format != "csv" && options.format != "json")
+  {
+    std::cerr << "Unknown format: " << options.format << std::endl;
+    return 1;
+  }
+
+  benchPushInterpolate();
+  benchLogs();
+  benchNamedSessions();
+
+  std::ofstream file;
+  if (options.output != "")
+  {
+    file.open(options.output);
+    if (!file)
+    {
+      std::cerr << "Failed to open " << options.output << std::endl;
+      return 1;
+    }
+  }
+  std::ostream& os = options.output != "" ? file : std::cout;
+  if (options.format == "json")
+  {
+    writeJSON(os);
+  }
+  else
+  {
+    writeCSV(os);
+  }
+  return 0;
+}
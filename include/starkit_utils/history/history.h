@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 #include <deque>
 #include <map>
 #include <memory>
@@ -10,16 +11,26 @@
 #include <iostream>
 #include <ostream>
 #include <fstream>
+#include <vector>
+
+#include "starkit_utils/history/history_aggregates.h"
+#include "starkit_utils/history/history_pyramid.h"
+#include "starkit_utils/history/history_ring.h"
+#include "starkit_utils/history/typed_history.h"
 
 namespace starkit_utils
 {
+class HistoryLogWriter;
+
 /**
  * History
  *
  * Class for queue past value and
  * interpole them back in the past.
+ * Scalar instance of TypedHistory adding
+ * angle interpolation, logging and replay.
  */
-class History
+class History : protected TypedHistory<double>
 {
 public:
   enum ValueType
@@ -28,13 +39,86 @@ public:
     AngleRad = 1
   };
 
+  /**
+   * Log file formats. Compressed logs are
+   * described in HistoryCodec
+   */
+  enum LogFormat
+  {
+    Ascii = 0,
+    Binary = 1,
+    Compressed = 2
+  };
+
+  /**
+   * Interpolation kernels. Cubic kernels use the
+   * two points surrounding the timestamp and their
+   * outer neighbours:
+   * - CatmullRom: tangents from the neighbours, smooth
+   *   but may overshoot
+   * - MonotoneCubic: Fritsch-Carlson tangents, never
+   *   overshoots the surrounding points
+   * With AngleRad values, neighbours are unwrapped
+   * around the lower point before interpolation
+   */
+  enum Kernel
+  {
+    Linear = 0,
+    CatmullRom = 1,
+    MonotoneCubic = 2
+  };
+
   typedef std::pair<double, double> TimedValue;
 
+  /**
+   * Cursor
+   *
+   * Remember the last bracketing index of a History
+   * so that interpolating at increasing timestamps costs
+   * amortized O(1) instead of a full bijection search.
+   * A cursor is not thread-safe, use one per thread.
+   */
+  class Cursor
+  {
+  public:
+    Cursor(const History& history);
+
+    /**
+     * Same as History::interpolate
+     */
+    double interpolate(double timestamp, ValueType valueType = Number);
+    double interpolate(double timestamp, Kernel kernel, ValueType valueType = Number);
+
+    /**
+     * Forget the last position
+     */
+    void reset();
+
+  private:
+    const History* _history;
+    uint64_t _index;
+  };
+
   /**
    * Initialization in timestamp duration
    */
   History(double window = 2.0);
 
+  /**
+   * Initialization in lock-free mode: values are stored
+   * in a preallocated ring buffer of given capacity.
+   * A single thread may push values while any number of
+   * threads interpolate, pushValue never blocks nor allocates.
+   * Logging, named sessions and replay are not available
+   * in this mode.
+   */
+  History(double window, size_t ringCapacity);
+
+  /**
+   * Return true if the history is backed by a lock-free ring
+   */
+  bool isLockFree() const;
+
   /**
    * Sets the history window size
    */
@@ -47,9 +131,10 @@ public:
 
   /**
    * Return first and last recorded point
+   * (a copy, since the container may be concurrently updated)
    */
-  const TimedValue& front() const;
-  const TimedValue& back() const;
+  TimedValue front() const;
+  TimedValue back() const;
 
   /**
    * Insert a new value in the container
@@ -64,6 +149,35 @@ public:
    */
   double interpolate(double timestamp, ValueType valueType = Number) const;
 
+  /**
+   * Same as interpolate using given kernel
+   */
+  double interpolate(double timestamp, Kernel kernel, ValueType valueType = Number) const;
+
+  /**
+   * Interpolate n timestamps at once and store the
+   * results in out. The lock is taken only once and
+   * increasing timestamps are walked with a merge-style
+   * sweep instead of independent searches
+   */
+  void interpolateBatch(const double* timestamps, size_t n, double* out, ValueType valueType = Number) const;
+
+  /**
+   * Interpolate at given timestamp between the two
+   * surrounding points low and up. If both share the same
+   * timestamp, the value of low is returned
+   */
+  static double interpolateBracket(const TimedValue& low, const TimedValue& up, double timestamp,
+                                   ValueType valueType = Number);
+
+  /**
+   * Interpolate at given timestamp between points[1] and points[2]
+   * with given kernel, points[0] and points[3] being their outer
+   * neighbours (or copies of points[1] and points[2] if missing)
+   */
+  static double interpolateNeighbours(const TimedValue points[4], double timestamp, Kernel kernel,
+                                      ValueType valueType = Number);
+
   /**
    * Enable to logging mode.
    */
@@ -77,6 +191,19 @@ public:
    */
   void stopLogging(std::ostream& os, bool binary = false);
 
+  /**
+   * Stop logging and dump all recorded
+   * values into given output stream using given format
+   */
+  void stopLogging(std::ostream& os, LogFormat format);
+
+  /**
+   * Stop logging and hand a copy of the recorded values
+   * to the given writer which dumps them into os from its
+   * own thread. Return the ticket of the writer job.
+   */
+  uint64_t stopLogging(HistoryLogWriter& writer, std::shared_ptr<std::ostream> os, LogFormat format = Ascii);
+
   /**
    * Open a log session with the given name, throws a logic_error if a
    * session with the given name is already opened
@@ -94,7 +221,15 @@ public:
    * there is no frozen session with the given name opened. High time
    * consumption.
    */
-  void closeFrozenLog(const std::string& sessionName, std::ostream& os);
+  void closeFrozenLog(const std::string& sessionName, std::ostream& os, LogFormat format = Binary);
+
+  /**
+   * Close a frozen log session by handing its buffer to the given
+   * writer, which writes it into os from its own thread.
+   * Low time consumption. Return the ticket of the writer job.
+   */
+  uint64_t closeFrozenLog(const std::string& sessionName, HistoryLogWriter& writer, std::shared_ptr<std::ostream> os,
+                          LogFormat format = Binary);
 
   /**
    * Read data from given input stream
@@ -102,10 +237,57 @@ public:
    * commented "#" line.
    * If binary is true, log file is read in
    * binary format
+   * Compressed logs are detected and decoded
+   * whatever the value of binary
    * Optional time shift is apply on read timestamp
    */
   void loadReplay(std::istream& is, bool binary = false, double timeShift = 0.0);
 
+  /**
+   * Replace the content with the given values, as read
+   * from a log by loadReplay
+   */
+  void loadReplay(const std::vector<TimedValue>& values, double timeShift = 0.0);
+
+  /**
+   * Read only the part of a binary or compressed log
+   * needed to cover [tStart, tEnd] (timestamps after
+   * time shift), seeking directly to it in the given
+   * seekable stream. The last point before tStart and
+   * the first point after tEnd are kept to interpolate
+   * over the whole range. As with loadReplay, empty logs
+   * give an empty History and truncated binary logs are
+   * read up to their last complete point
+   */
+  void loadReplayRange(std::istream& is, double tStart, double tEnd, double timeShift = 0.0);
+
+  /**
+   * Maintain a downsampled pyramid of the values (see HistoryPyramid),
+   * built from the current values and updated by pushValue and
+   * loadReplay. Not available in lock-free mode
+   */
+  void enablePyramid(size_t factor = 10, size_t nbLevels = 3);
+
+  /**
+   * Return the values between tStart and tEnd as buckets, using
+   * the raw values if there are at most maxPoints of them or the
+   * most detailed pyramid level fitting in maxPoints otherwise.
+   * Without pyramid, raw values are always returned
+   */
+  std::vector<HistoryPyramid::Bucket> query(double tStart, double tEnd, size_t maxPoints) const;
+
+  /**
+   * Maintain min, max, mean and variance of the stored values
+   * (the window, or all values while logging), updated in amortized
+   * O(1) by pushValue and loadReplay. Not available in lock-free mode
+   */
+  void enableAggregates();
+
+  /**
+   * Current aggregates, throws a logic_error if not enabled
+   */
+  HistoryAggregates::Summary getAggregates() const;
+
   /**
    * Getting all values
    */
@@ -123,9 +305,48 @@ private:
   static void writeBinary(const std::deque<TimedValue>& values, std::ostream& os);
 
   /**
-   * Mutex for concurent access
+   * Stop logging and return a copy of the values to dump along with
+   * the first timestamp to write in ascii
    */
-  mutable std::mutex _mutex;
+  std::unique_ptr<std::deque<TimedValue>> takeLoggedValues(double& startTime);
+
+  /**
+   * Append a point read by loadReplay, _mutex must be locked
+   */
+  void appendReplayValue(double timestamp, double value);
+
+  /**
+   * Remove all values, _mutex must be locked
+   */
+  void clearValuesLocked();
+
+  /**
+   * Remove and return the frozen session with given name
+   */
+  std::unique_ptr<std::deque<TimedValue>> takeFrozenLog(const std::string& sessionName);
+
+  /**
+   * Retrieve the points surrounding the given timestamp
+   * (see HistoryRing::bracket), starting the search from
+   * the logical index hint and updating it
+   */
+  bool bracket(double timestamp, TimedValue& low, TimedValue& up, uint64_t& hint) const;
+
+  /**
+   * Same as bracket, also retrieving the outer neighbours
+   * (see TypedHistory::neighboursLocked)
+   */
+  bool neighbours(double timestamp, TimedValue points[4], uint64_t& hint) const;
+
+  /**
+   * Interpolate between the given bounding points
+   */
+  static double blend(const TimedValue& low, const TimedValue& up, double timestamp, ValueType valueType);
+
+  /**
+   * Throw a logic_error if the history is in lock-free mode
+   */
+  void checkNotLockFree(const std::string& operation) const;
 
   /**
    * If true, the instance is in logging state
@@ -140,15 +361,20 @@ private:
   double _startLoggingTime;
 
   /**
-   * Rolling buffer size in timestamp
+   * Lock-free storage used instead of the
+   * TypedHistory container when not null
+   */
+  std::unique_ptr<HistoryRing> _ring;
+
+  /**
+   * Optional downsampled values
    */
-  double _windowSize;
+  std::unique_ptr<HistoryPyramid> _pyramid;
 
   /**
-   * Values container indexed
-   * by their timestamp
+   * Optional window aggregates
    */
-  std::deque<TimedValue> _values;
+  std::unique_ptr<HistoryAggregates> _aggregates;
 
   /**
    * Named log sessions to which the object is actively writting
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+namespace starkit_utils
+{
+/**
+ * HistoryAggregates
+ *
+ * Min, max, mean and variance of a FIFO of values, updated in
+ * amortized O(1) when a value enters or leaves. Min and max use
+ * monotonic queues, mean and variance Welford's running sums.
+ */
+class HistoryAggregates
+{
+public:
+  struct Summary
+  {
+    size_t count;
+    double min;
+    double max;
+    double mean;
+    /**
+     * Population variance, as starkit_utils::variance
+     */
+    double variance;
+  };
+
+  HistoryAggregates();
+
+  /**
+   * Add a value at the back of the FIFO
+   */
+  void push(double value);
+
+  /**
+   * Remove the given value, which must be the one at
+   * the front of the FIFO
+   */
+  void pop(double value);
+
+  void clear();
+
+  /**
+   * Current aggregates, all fields are 0 if empty
+   */
+  Summary summary() const;
+
+private:
+  /**
+   * Number of values pushed and popped so far
+   */
+  uint64_t _nbPushed;
+  uint64_t _nbPopped;
+
+  /**
+   * Candidates for min and max with their index,
+   * increasing (resp. decreasing) values
+   */
+  std::deque<std::pair<uint64_t, double>> _minQueue;
+  std::deque<std::pair<uint64_t, double>> _maxQueue;
+
+  /**
+   * Welford running mean and sum of squared deviations
+   */
+  double _mean;
+  double _m2;
+};
+
+}  // namespace starkit_utils
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace starkit_utils
+{
+/**
+ * HistoryCodec
+ *
+ * Compressed format for History logs. Points are grouped in
+ * blocks which can be decoded independently. Inside a block,
+ * timestamps are stored as delta-of-delta of their bit patterns
+ * and values are XORed with the previous one (Gorilla encoding),
+ * which is lossless and very compact for fixed rate sensors.
+ *
+ * File layout:
+ * - Magic (8 bytes)
+ * - Blocks: BlockHeader followed by nbBytes of encoded points
+ * - End marker: BlockHeader with nbPoints = 0
+ * - Index: number of blocks (uint64) and one IndexEntry per block
+ * - Trailer: offset of the index (uint64) and IndexMagic (8 bytes)
+ *
+ * Offsets are relative to the beginning of the log. The index
+ * allows to seek directly to the blocks covering a time range.
+ */
+class HistoryCodec
+{
+public:
+  typedef std::pair<double, double> TimedValue;
+
+  /**
+   * First bytes of a compressed log. Starting with a non ascii
+   * character, it can't be confused with an ascii log, and read
+   * as a size_t it can't be confused with a raw binary one
+   */
+  static const char Magic[8];
+
+  /**
+   * Last bytes of a compressed log with an index
+   */
+  static const char IndexMagic[8];
+
+  /**
+   * Default number of points per block
+   */
+  static const size_t DefaultBlockSize;
+
+  struct BlockHeader
+  {
+    uint32_t nbPoints;
+    uint32_t nbBytes;
+    double firstTimestamp;
+    double lastTimestamp;
+  };
+
+  /**
+   * Serialized size of a block header
+   */
+  static const size_t BlockHeaderSize;
+
+  struct IndexEntry
+  {
+    double firstTimestamp;
+    double lastTimestamp;
+    uint64_t offset;
+  };
+
+  /**
+   * Write the values in compressed format
+   */
+  static void encode(const std::deque<TimedValue>& values, std::ostream& os, size_t blockSize = DefaultBlockSize);
+
+  /**
+   * Encode the given points into a block payload
+   */
+  static std::string encodeBlock(const TimedValue* points, size_t nbPoints);
+
+  /**
+   * Decode a block payload and append its points to the given container
+   */
+  static void decodeBlock(const std::string& bytes, size_t nbPoints, std::vector<TimedValue>& points);
+
+  /**
+   * Read the whole compressed log (magic included) and decode its
+   * blocks on nbThreads threads
+   */
+  static std::vector<TimedValue> decode(std::istream& is, int nbThreads = 1);
+
+  /**
+   * Read the block index of the compressed log starting at the current
+   * position of the seekable stream. If the log has no index, it is
+   * rebuilt by skipping from block header to block header. The stream
+   * position is left undefined
+   */
+  static std::vector<IndexEntry> readIndex(std::istream& is);
+
+  /**
+   * Decode only the blocks of the compressed log starting at the current
+   * position of the seekable stream which are needed to cover [tStart, tEnd].
+   * Returned points are the ones inside the range plus the last point before
+   * tStart and the first after tEnd, if any
+   */
+  static std::vector<TimedValue> decodeRange(std::istream& is, double tStart, double tEnd);
+
+  static void writeBlockHeader(const BlockHeader& header, std::ostream& os);
+
+  /**
+   * Read a block header, throws a runtime_error if the stream ends
+   */
+  static BlockHeader readBlockHeader(std::istream& is);
+
+  /**
+   * Reader
+   *
+   * Streaming decoder, one block at a time
+   */
+  class Reader
+  {
+  public:
+    /**
+     * If readMagic is false, the magic is expected to have already
+     * been consumed from the stream
+     */
+    Reader(std::istream& is, bool readMagic = true);
+
+    /**
+     * Read the next encoded block, return false at the end of the log
+     */
+    bool nextEncodedBlock(BlockHeader& header, std::string& bytes);
+
+    /**
+     * Replace the content of points with the next block,
+     * return false at the end of the log
+     */
+    bool nextBlock(std::vector<TimedValue>& points);
+
+  private:
+    std::istream& _is;
+    bool _ended;
+  };
+};
+
+}  // namespace starkit_utils
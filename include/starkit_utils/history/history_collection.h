@@ -0,0 +1,143 @@
+#pragma once
+
+#include "starkit_utils/history/history.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace starkit_utils
+{
+/**
+ * HistoryCollection
+ *
+ * Set of channels sharing the same timestamps. A single
+ * timestamp column is stored along with one row of values
+ * per timestamp, so that all the channels are interpolated
+ * with a single bracket search and a contiguous blend.
+ */
+class HistoryCollection
+{
+public:
+  /**
+   * Initialization in timestamp duration
+   */
+  HistoryCollection(double window = 2.0);
+
+  /**
+   * Sets the history window size
+   */
+  void setWindowSize(double window);
+
+  /**
+   * Declare a new channel and return its index. Throws a logic_error
+   * if the name is already used or if values have already been pushed
+   */
+  size_t addChannel(const std::string& name, History::ValueType valueType = History::Number);
+
+  /**
+   * Number of channels and index of a channel from its name,
+   * throws an out_of_range if the channel does not exist
+   */
+  size_t nbChannels() const;
+  size_t getChannelIndex(const std::string& name) const;
+  std::string getChannelName(size_t channel) const;
+
+  /**
+   * Return the number of stored timestamps
+   */
+  size_t size() const;
+
+  /**
+   * First and last recorded timestamps, 0 if empty
+   */
+  double frontTimestamp() const;
+  double backTimestamp() const;
+
+  /**
+   * Insert a new row, values must contain one entry per channel.
+   * Same semantics as History::pushValue for timestamps
+   */
+  void pushValues(double timestamp, const double* values);
+  void pushValues(double timestamp, const std::vector<double>& values);
+
+  /**
+   * Interpolate all channels at given timestamp, out must have room
+   * for one entry per channel. Values are 0 if the collection is empty
+   */
+  void interpolateAll(double timestamp, double* out) const;
+  void interpolateAll(double timestamp, std::vector<double>& out) const;
+
+  /**
+   * Interpolate a single channel
+   */
+  double interpolate(size_t channel, double timestamp) const;
+
+  /**
+   * Clearing all values, channels are kept
+   */
+  void clear();
+
+private:
+  /**
+   * pushValues and interpolateAll, _mutex must be held
+   */
+  void pushValuesLocked(double timestamp, const double* values);
+  void interpolateAllLocked(double timestamp, double* out) const;
+
+  /**
+   * Storage index of the row at given position from _head
+   */
+  size_t rowIndex(size_t row) const;
+
+  /**
+   * Double the ring capacity, moving the rows to the beginning
+   */
+  void grow();
+
+  /**
+   * Find the rows (relative to _head) bounding timestamp and
+   * the weight of the upper one. Requires a non empty container
+   */
+  void bracket(double timestamp, size_t& rowLow, size_t& rowUp, double& wUp) const;
+
+  /**
+   * Blend the channel values of two rows into out
+   */
+  void blendRows(const double* low, const double* up, double wUp, double* out) const;
+
+  /**
+   * Mutex for concurent access
+   */
+  mutable std::mutex _mutex;
+
+  /**
+   * Rolling buffer size in timestamp
+   */
+  double _windowSize;
+
+  /**
+   * Channels description
+   */
+  std::vector<std::string> _names;
+  std::vector<History::ValueType> _types;
+  std::map<std::string, size_t> _indices;
+
+  /**
+   * Indices of the AngleRad channels
+   */
+  std::vector<size_t> _angleChannels;
+
+  /**
+   * Timestamp column and rows of values (nbChannels per row), used as a
+   * ring of _size rows starting at _head. The capacity only grows while
+   * the window fills up, so that pushing never moves the stored rows
+   */
+  std::vector<double> _timestamps;
+  std::vector<double> _values;
+  size_t _head;
+  size_t _size;
+};
+
+}  // namespace starkit_utils
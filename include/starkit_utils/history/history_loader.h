@@ -0,0 +1,42 @@
+#pragma once
+
+#include "starkit_utils/history/history.h"
+
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace starkit_utils
+{
+/**
+ * HistoryLoader
+ *
+ * Bulk loading of History logs
+ */
+class HistoryLoader
+{
+public:
+  typedef std::map<std::string, std::unique_ptr<History>> Histories;
+
+  /**
+   * Load all the regular files of the given directory whose name ends
+   * with extension (all non hidden files if empty) on nbThreads threads
+   * (hardware concurrency if 0). Logs are read as binary or ascii
+   * depending on binary, compressed logs are always detected.
+   * Histories are indexed by file name without extension.
+   * Throws a runtime_error if the directory or one of the logs can't be read
+   */
+  static Histories loadReplayDirectory(const std::string& directory, bool binary = false, double timeShift = 0.0,
+                                       int nbThreads = 0, const std::string& extension = "");
+
+  /**
+   * Parse an ascii log as History::loadReplay (until the stream end or
+   * the first "#" line) reading it by large chunks. The whole stream
+   * may be consumed. Throws a runtime_error on malformed lines
+   */
+  static std::vector<History::TimedValue> parseAscii(std::istream& is);
+};
+
+}  // namespace starkit_utils
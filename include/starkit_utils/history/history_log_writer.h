@@ -0,0 +1,123 @@
+#pragma once
+
+#include "starkit_utils/history/history.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+namespace starkit_utils
+{
+/**
+ * HistoryLogWriter
+ *
+ * Service writing History logs from a dedicated I/O thread.
+ * Buffers are handed over (History::closeFrozenLog and
+ * History::stopLogging overloads) and serialized in large
+ * chunks, so that the calling thread never pays for the
+ * formatting nor the I/O.
+ *
+ * Each job receives a ticket, jobs are written in order.
+ */
+class HistoryLogWriter
+{
+public:
+  typedef History::TimedValue TimedValue;
+
+  /**
+   * Start the I/O thread
+   */
+  HistoryLogWriter();
+
+  /**
+   * Write all pending jobs and stop the I/O thread
+   */
+  ~HistoryLogWriter();
+
+  HistoryLogWriter(const HistoryLogWriter& other) = delete;
+  HistoryLogWriter& operator=(const HistoryLogWriter& other) = delete;
+
+  /**
+   * Queue the given values to be written to os in given format.
+   * In ascii, values before startTime are skipped.
+   * Return the ticket of the job.
+   */
+  uint64_t push(std::unique_ptr<std::deque<TimedValue>> values, std::shared_ptr<std::ostream> os,
+                History::LogFormat format = History::Binary,
+                double startTime = -std::numeric_limits<double>::infinity());
+
+  /**
+   * Return true if the job with given ticket has been written
+   */
+  bool isDone(uint64_t ticket) const;
+
+  /**
+   * Block until the job with given ticket has been written and
+   * its stream flushed. Throws a runtime_error if this job failed
+   * and a logic_error if the ticket was not issued.
+   */
+  void wait(uint64_t ticket);
+
+  /**
+   * Block until all the jobs queued so far are written and flushed.
+   * Throws a runtime_error if one of them failed and its error was
+   * not reported yet.
+   */
+  void flush();
+
+  /**
+   * Number of jobs not written yet
+   */
+  size_t pendingJobs() const;
+
+  /**
+   * Serialize values to the given stream using large chunks, in a
+   * format read by History::loadReplay. In ascii, values before
+   * startTime are skipped
+   */
+  static void write(const std::deque<TimedValue>& values, std::ostream& os, History::LogFormat format,
+                    double startTime = -std::numeric_limits<double>::infinity());
+
+private:
+  struct Job
+  {
+    std::unique_ptr<std::deque<TimedValue>> values;
+    std::shared_ptr<std::ostream> os;
+    History::LogFormat format;
+    double startTime;
+    uint64_t ticket;
+  };
+
+  /**
+   * I/O thread main loop
+   */
+  void run();
+
+  /**
+   * Throw the first recorded error of the jobs with a ticket
+   * between first and last if any, _mutex must be locked
+   */
+  void checkErrors(uint64_t first, uint64_t last);
+
+  mutable std::mutex _mutex;
+  std::condition_variable _jobsCondition;
+  std::condition_variable _doneCondition;
+
+  std::deque<Job> _jobs;
+  uint64_t _lastTicket;
+  uint64_t _lastDone;
+  // Errors of the failed jobs not reported yet, by ticket
+  std::map<uint64_t, std::string> _errors;
+  bool _stop;
+
+  std::thread _thread;
+};
+
+}  // namespace starkit_utils
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+namespace starkit_utils
+{
+/**
+ * HistoryPyramid
+ *
+ * Downsampled summaries of a stream of timed values. Level k
+ * (starting at 1) groups factor^k consecutive points in buckets
+ * holding their min, max and mean. Buckets are built incrementally
+ * while points are pushed, so that long recordings can be plotted
+ * by reading a few thousands buckets instead of all the points.
+ *
+ * Aggregates are only meaningful for History::Number values.
+ */
+class HistoryPyramid
+{
+public:
+  struct Bucket
+  {
+    double tStart;
+    double tEnd;
+    double min;
+    double max;
+    double mean;
+    size_t count;
+  };
+
+  HistoryPyramid(size_t factor = 10, size_t nbLevels = 3);
+
+  size_t factor() const;
+  size_t nbLevels() const;
+
+  /**
+   * Add a point, timestamps are expected to be increasing
+   */
+  void push(double timestamp, double value);
+
+  /**
+   * Remove completed buckets ending before given timestamp
+   */
+  void dropBefore(double timestamp);
+
+  void clear();
+
+  /**
+   * Number of buckets of given level (1 to nbLevels) overlapping
+   * [tStart, tEnd], including the bucket being filled
+   */
+  size_t count(size_t level, double tStart, double tEnd) const;
+
+  /**
+   * Append to out the buckets of given level overlapping [tStart, tEnd],
+   * the last one may be partially filled
+   */
+  void query(size_t level, double tStart, double tEnd, std::vector<Bucket>& out) const;
+
+  /**
+   * Return the buckets of the most detailed level having at most
+   * maxPoints buckets overlapping [tStart, tEnd], or the ones of
+   * the coarsest level if none fits
+   */
+  std::vector<Bucket> query(double tStart, double tEnd, size_t maxPoints) const;
+
+private:
+  /**
+   * Bucket being filled, mean holds the sum of the values
+   */
+  struct Pending
+  {
+    Bucket bucket;
+    size_t size;
+  };
+
+  /**
+   * Range of completed buckets of given level overlapping [tStart, tEnd]
+   */
+  void range(size_t level, double tStart, double tEnd, size_t& first, size_t& last) const;
+
+  bool pendingOverlaps(size_t level, double tStart, double tEnd) const;
+
+  size_t _factor;
+
+  /**
+   * Completed buckets and bucket being filled for each level,
+   * level k is stored at index k - 1
+   */
+  std::vector<std::deque<Bucket>> _levels;
+  std::vector<Pending> _pending;
+};
+
+}  // namespace starkit_utils
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "starkit_utils/history/history.h"
+#include "starkit_utils/timing/time_stamp.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace starkit_utils
+{
+/**
+ * HistoryReplayer
+ *
+ * Play back recorded Histories against a virtual clock.
+ * The values of all channels are merged into a single
+ * time-ordered stream of events (k-way merge using a
+ * heap) which is published to consumers in real time,
+ * N times faster, or as fast as possible.
+ *
+ * run() plays the events from the calling thread, the
+ * other methods may be called from any thread (including
+ * consumers) to pause, resume, step or stop it.
+ */
+class HistoryReplayer
+{
+public:
+  struct Event
+  {
+    size_t channel;
+    double timestamp;
+    double value;
+  };
+
+  typedef std::function<void(const Event& event)> Consumer;
+
+  /**
+   * Speed value playing events without waiting
+   */
+  static const double AsFastAsPossible;
+
+  HistoryReplayer();
+
+  /**
+   * Add a copy of the values of the given history as a new channel,
+   * return its index. Rewinds the replay
+   */
+  size_t addChannel(const std::string& name, History& history);
+
+  size_t nbChannels() const;
+  std::string getChannelName(size_t channel) const;
+
+  /**
+   * Add a function called for each event, from the
+   * thread playing it. Consumers must be added before
+   * playing events
+   */
+  void addConsumer(Consumer consumer);
+
+  /**
+   * Ratio between virtual and real durations, AsFastAsPossible
+   * (or any value <= 0) to play without waiting
+   */
+  void setSpeed(double speed);
+  double getSpeed() const;
+
+  /**
+   * Go back to the first event
+   */
+  void rewind();
+
+  /**
+   * Publish the next event, return false if there is none left.
+   * A concurrent run() keeps its pace from the new virtual time
+   */
+  bool step();
+
+  /**
+   * Publish all the events up to given virtual timestamp,
+   * return the number of published events
+   */
+  size_t stepUntil(double timestamp);
+
+  /**
+   * Publish the events at the configured speed until all are
+   * published or stop() is called. Blocks while paused
+   */
+  void run();
+
+  void pause();
+  void resume();
+  bool isPaused() const;
+
+  /**
+   * Make the current (or next) run() return as soon as possible
+   */
+  void stop();
+
+  /**
+   * Return true if all events have been published
+   */
+  bool isOver() const;
+
+  /**
+   * Timestamp of the last published event (first event
+   * timestamp before any publication)
+   */
+  double getTime() const;
+
+  /**
+   * Virtual time as a TimeStamp, getTime() seconds after
+   * the steady clock epoch
+   */
+  TimeStamp getTimeStamp() const;
+
+private:
+  struct Channel
+  {
+    std::string name;
+    std::vector<History::TimedValue> values;
+    size_t next;
+  };
+
+  /**
+   * Heap entry, the next event of a channel
+   */
+  struct Head
+  {
+    double timestamp;
+    size_t channel;
+
+    bool operator>(const Head& other) const
+    {
+      return timestamp > other.timestamp || (timestamp == other.timestamp && channel > other.channel);
+    }
+  };
+
+  /**
+   * Rebuild the heap from the first events, _mutex must be locked
+   */
+  void rewindLocked();
+
+  /**
+   * Pop the next event, _mutex must be locked
+   */
+  bool popLocked(Event& event);
+
+  /**
+   * Call consumers, _mutex must not be locked
+   */
+  void publish(const Event& event);
+
+  mutable std::mutex _mutex;
+  std::condition_variable _condition;
+
+  std::vector<Channel> _channels;
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head>> _heap;
+  std::vector<Consumer> _consumers;
+
+  double _speed;
+  bool _paused;
+  bool _stopped;
+
+  /**
+   * Incremented on any pace change so that run()
+   * takes a new real time reference
+   */
+  uint64_t _paceVersion;
+
+  std::atomic<double> _time;
+};
+
+}  // namespace starkit_utils
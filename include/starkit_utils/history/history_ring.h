@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+
+namespace starkit_utils
+{
+/**
+ * HistoryRing
+ *
+ * Fixed capacity ring buffer of timed values with one writer
+ * and any number of concurrent readers. The writer never blocks
+ * nor allocates. Each slot is protected by a sequence counter
+ * (seqlock): readers validate what they copied and retry when
+ * the writer overwrote the slot in the meantime.
+ *
+ * The ring either owns its storage or is laid over an external
+ * memory area of requiredBytes(capacity) bytes.
+ */
+class HistoryRing
+{
+public:
+  typedef std::pair<double, double> TimedValue;
+
+  /**
+   * Shared state at the beginning of the memory area
+   */
+  struct Header
+  {
+    uint64_t capacity;
+    std::atomic<double> windowSize;
+    /**
+     * Logical index of the oldest point inside the window
+     */
+    std::atomic<uint64_t> start;
+    /**
+     * Logical index following the last published point
+     */
+    std::atomic<uint64_t> end;
+    /**
+     * Last pushed timestamp, only accessed by the writer
+     */
+    double lastTimestamp;
+  };
+
+  /**
+   * Point storage. seq is odd while the writer is updating
+   * the slot and equals 2*(generation+1) once written
+   */
+  struct Slot
+  {
+    std::atomic<uint64_t> seq;
+    std::atomic<double> timestamp;
+    std::atomic<double> value;
+  };
+
+  /**
+   * Number of bytes needed to hold a ring of given capacity
+   */
+  static size_t requiredBytes(size_t capacity);
+
+  /**
+   * Allocate an owned ring with given capacity and window size
+   */
+  HistoryRing(size_t capacity, double window);
+
+  /**
+   * Use the external memory area (of at least requiredBytes(capacity)
+   * bytes). If initialize is true, the area is (re)initialized,
+   * otherwise it is expected to already contain a ring.
+   */
+  HistoryRing(void* memory, size_t capacity, double window, bool initialize);
+
+  size_t capacity() const;
+
+  /**
+   * Writer side. Push a new point, throws a logic_error if the
+   * timestamp is decreasing. Return false if the point has been
+   * ignored because the timestamp is already the last one.
+   */
+  bool push(double timestamp, double value);
+
+  /**
+   * Writer side. Drop all points.
+   */
+  void clear();
+
+  /**
+   * Sets the window size in timestamp
+   */
+  void setWindowSize(double window);
+
+  /**
+   * Reader side. Number of points currently inside the window
+   */
+  size_t size() const;
+
+  /**
+   * Reader side. Oldest and newest points, {0,0} if empty
+   */
+  TimedValue front() const;
+  TimedValue back() const;
+
+  /**
+   * Reader side. Retrieve the consistent pair of points surrounding
+   * the given timestamp. Both are equal when the timestamp is outside
+   * of the stored range or when there is a single point.
+   * Return false if the ring is empty.
+   * If hint is provided, the search starts from the logical index
+   * it contains (galloping forward) and it is updated with the index
+   * of the lower point, making increasing queries amortized O(1).
+   */
+  bool bracket(double timestamp, TimedValue& low, TimedValue& up, uint64_t* hint = nullptr) const;
+
+  /**
+   * Same as bracket, also retrieving the outer neighbours of
+   * low and up (see TypedHistory::neighboursLocked)
+   */
+  bool neighbours(double timestamp, TimedValue points[4], uint64_t* hint = nullptr) const;
+
+  /**
+   * Reader side. Copy all points currently inside the window
+   */
+  std::deque<TimedValue> snapshot() const;
+
+private:
+  /**
+   * Copy the point at the given logical index, return false if the
+   * slot does not (or no more) contain this index
+   */
+  bool read(uint64_t index, TimedValue& value) const;
+
+  /**
+   * Read the published bounds [start, end[
+   */
+  void bounds(uint64_t& start, uint64_t& end) const;
+
+  void initialize(size_t capacity, double window);
+
+  std::unique_ptr<unsigned char[]> _storage;
+  Header* _header;
+  Slot* _slots;
+};
+
+}  // namespace starkit_utils
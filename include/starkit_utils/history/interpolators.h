@@ -0,0 +1,102 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <cmath>
+
+namespace starkit_utils
+{
+/**
+ * Interpolators used by TypedHistory. An interpolator provides:
+ * - T operator()(const T& low, double wLow, const T& up, double wUp) const
+ *   blending two values with weights summing to 1
+ * - T zero() const
+ *   the value returned when interpolating an empty history
+ */
+
+/**
+ * Linear blend, for scalars and Eigen vectors
+ */
+template <typename T>
+struct LinearInterpolator
+{
+  T operator()(const T& low, double wLow, const T& up, double wUp) const
+  {
+    return wLow * low + wUp * up;
+  }
+
+  T zero() const
+  {
+    return T::Zero();
+  }
+};
+
+template <>
+inline double LinearInterpolator<double>::zero() const
+{
+  return 0.0;
+}
+
+/**
+ * Spherical linear interpolation of rotations
+ */
+struct QuaternionInterpolator
+{
+  Eigen::Quaterniond operator()(const Eigen::Quaterniond& low, double wLow, const Eigen::Quaterniond& up,
+                                double wUp) const
+  {
+    (void)wLow;
+    return low.slerp(wUp, up);
+  }
+
+  Eigen::Quaterniond zero() const
+  {
+    return Eigen::Quaterniond::Identity();
+  }
+};
+
+/**
+ * SE(2) poses stored as (x, y, theta) with theta in radians.
+ * Position is blended linearly, orientation on the unit circle
+ */
+struct Pose2DInterpolator
+{
+  Eigen::Vector3d operator()(const Eigen::Vector3d& low, double wLow, const Eigen::Vector3d& up, double wUp) const
+  {
+    Eigen::Vector3d result = wLow * low + wUp * up;
+    result(2) = std::atan2(wLow * std::sin(low(2)) + wUp * std::sin(up(2)),
+                           wLow * std::cos(low(2)) + wUp * std::cos(up(2)));
+    return result;
+  }
+
+  Eigen::Vector3d zero() const
+  {
+    return Eigen::Vector3d::Zero();
+  }
+};
+
+/**
+ * SE(3) poses. Translation is blended linearly,
+ * rotation with a spherical linear interpolation
+ */
+struct Pose3DInterpolator
+{
+  Eigen::Isometry3d operator()(const Eigen::Isometry3d& low, double wLow, const Eigen::Isometry3d& up,
+                               double wUp) const
+  {
+    Eigen::Quaterniond rotationLow(low.linear());
+    Eigen::Quaterniond rotationUp(up.linear());
+    Eigen::Isometry3d result = Eigen::Isometry3d::Identity();
+    result.linear() = rotationLow.slerp(wUp, rotationUp).toRotationMatrix();
+    result.translation() = wLow * low.translation() + wUp * up.translation();
+    return result;
+  }
+
+  Eigen::Isometry3d zero() const
+  {
+    return Eigen::Isometry3d::Identity();
+  }
+};
+
+}  // namespace starkit_utils
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "starkit_utils/history/history.h"
+
+#include <string>
+
+namespace starkit_utils
+{
+/**
+ * MappedHistory
+ *
+ * Read-only view on a History binary log (as written by
+ * History::stopLogging or History::closeFrozenLog). The file
+ * is memory mapped and interpolated in place: opening is
+ * immediate whatever the log size, and pages are shared
+ * between all the processes reading the same file.
+ *
+ * Timestamps are assumed to be increasing as in any History log.
+ */
+class MappedHistory
+{
+public:
+  /**
+   * Map the binary log at given path, throws a runtime_error if the
+   * file cannot be mapped or is truncated. Optional time shift is
+   * applied on read timestamps
+   */
+  MappedHistory(const std::string& path, double timeShift = 0.0);
+  ~MappedHistory();
+
+  MappedHistory(const MappedHistory& other) = delete;
+  MappedHistory& operator=(const MappedHistory& other) = delete;
+
+  /**
+   * Return the number of points in the log
+   */
+  size_t size() const;
+
+  /**
+   * Return the point at given index (time shift applied)
+   */
+  History::TimedValue at(size_t index) const;
+
+  /**
+   * Return first and last recorded point
+   */
+  History::TimedValue front() const;
+  History::TimedValue back() const;
+
+  /**
+   * Same as History::interpolate
+   */
+  double interpolate(double timestamp, History::ValueType valueType = History::Number) const;
+
+private:
+  double timestampAt(size_t index) const;
+
+  double _timeShift;
+
+  /**
+   * Mapped area
+   */
+  void* _mapping;
+  size_t _mappingSize;
+
+  /**
+   * Points as interleaved (timestamp, value) doubles
+   */
+  const double* _data;
+  size_t _size;
+};
+
+}  // namespace starkit_utils
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "starkit_utils/history/history.h"
+#include "starkit_utils/history/history_ring.h"
+
+#include <memory>
+#include <string>
+
+namespace starkit_utils
+{
+/**
+ * SharedHistory
+ *
+ * History ring buffer (see HistoryRing) placed in a POSIX
+ * shared memory segment, so that a single writer process
+ * can publish values interpolated by reader processes on
+ * the same host without copy nor lock.
+ *
+ * The writer creates a fresh segment (a previous one with
+ * the same name is unlinked, processes still mapping it
+ * keep their view) and unlinks it when destroyed.
+ */
+class SharedHistory
+{
+public:
+  /**
+   * Writer side. Create the segment with given name, ring capacity
+   * and window size. Throws a runtime_error on failure
+   */
+  SharedHistory(const std::string& name, size_t capacity, double window = 2.0);
+
+  /**
+   * Reader side. Map the existing segment with given name read-only.
+   * Throws a runtime_error if it does not exist or is not initialized
+   */
+  SharedHistory(const std::string& name);
+
+  ~SharedHistory();
+
+  SharedHistory(const SharedHistory& other) = delete;
+  SharedHistory& operator=(const SharedHistory& other) = delete;
+
+  /**
+   * Return true if this instance created the segment
+   */
+  bool isWriter() const;
+
+  /**
+   * Segment name, starting with '/'
+   */
+  const std::string& getName() const;
+
+  size_t capacity() const;
+
+  /**
+   * Writer side, throws a logic_error on a reader.
+   * Same as History::setWindowSize and History::pushValue
+   */
+  void setWindowSize(double window);
+  void pushValue(double timestamp, double value);
+
+  /**
+   * Same as History methods
+   */
+  size_t size() const;
+  History::TimedValue front() const;
+  History::TimedValue back() const;
+  double interpolate(double timestamp, History::ValueType valueType = History::Number) const;
+  double interpolate(double timestamp, History::Kernel kernel, History::ValueType valueType = History::Number) const;
+
+private:
+  void checkWriter(const std::string& operation) const;
+
+  std::string _name;
+  bool _isWriter;
+  void* _mapping;
+  size_t _mappingSize;
+  std::unique_ptr<HistoryRing> _ring;
+};
+
+}  // namespace starkit_utils
@@ -0,0 +1,356 @@
+#pragma once
+
+#include "starkit_utils/history/interpolators.h"
+
+#include <Eigen/StdVector>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace starkit_utils
+{
+/**
+ * TypedHistory
+ *
+ * Queue of past values of type T indexed by their
+ * timestamp, interpolated back in the past with the
+ * given Interpolator (see interpolators.h).
+ *
+ * Values are stored in a chunked std::deque, so that
+ * pushValue never copies the stored values, even when
+ * the history grows without bound while logging.
+ *
+ * Examples:
+ * - TypedHistory<Eigen::Vector3d> for positions
+ * - TypedHistory<Eigen::Quaterniond, QuaternionInterpolator> for orientations
+ * - TypedHistory<Eigen::Vector3d, Pose2DInterpolator> for SE(2) poses
+ * - TypedHistory<Eigen::Isometry3d, Pose3DInterpolator> for SE(3) poses
+ */
+template <typename T, typename Interpolator = LinearInterpolator<T>>
+class TypedHistory
+{
+public:
+  typedef std::pair<double, T> TimedValue;
+  // Scalars need no alignment and use the standard container
+  typedef typename std::conditional<std::is_arithmetic<T>::value, std::allocator<TimedValue>,
+                                    Eigen::aligned_allocator<TimedValue>>::type Allocator;
+  typedef std::deque<TimedValue, Allocator> Container;
+
+  /**
+   * Initialization in timestamp duration
+   */
+  TypedHistory(double window = 2.0, const Interpolator& interpolator = Interpolator())
+    : _mutex(), _windowSize(window), _interpolator(interpolator), _values(), _nbDropped(0)
+  {
+  }
+
+  /**
+   * Sets the history window size
+   */
+  void setWindowSize(double window)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _windowSize = window;
+  }
+
+  /**
+   * Return the number of internal stored data
+   */
+  size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return sizeLocked();
+  }
+
+  /**
+   * Return first and last recorded point, or a point
+   * at timestamp 0 with the interpolator zero if empty
+   */
+  TimedValue front() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return sizeLocked() == 0 ? TimedValue(0.0, _interpolator.zero()) : frontLocked();
+  }
+  TimedValue back() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return sizeLocked() == 0 ? TimedValue(0.0, _interpolator.zero()) : _values.back();
+  }
+
+  /**
+   * Insert a new value in the container with given timestamp.
+   * Throws a logic_error if timestamp is decreasing, a value
+   * with the same timestamp as the last one is ignored
+   */
+  void pushValue(double timestamp, const T& value)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    pushLocked(timestamp, value, true);
+  }
+
+  /**
+   * Return either the nearest value or the value
+   * interpolated at given timestamp
+   */
+  T interpolate(double timestamp) const
+  {
+    return interpolate(timestamp, _interpolator);
+  }
+
+  /**
+   * Same as interpolate, using another interpolator
+   */
+  template <typename I>
+  T interpolate(double timestamp, const I& interpolator) const
+  {
+    uint64_t hint = NoHint;
+    TimedValue low, up;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!bracketLocked(timestamp, low, up, hint))
+      {
+        return interpolator.zero();
+      }
+    }
+    if (low.first == up.first)
+    {
+      return low.second;
+    }
+    double wLow = (up.first - timestamp) / (up.first - low.first);
+    double wUp = (timestamp - low.first) / (up.first - low.first);
+    return interpolator(low.second, wLow, up.second, wUp);
+  }
+
+  /**
+   * Getting all values
+   */
+  Container getValues() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return Container(beginLocked(), endLocked());
+  }
+
+  /**
+   * Clearing history values
+   */
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    clearLocked();
+  }
+
+protected:
+  /**
+   * Value used for an unset search hint
+   */
+  static constexpr uint64_t NoHint = std::numeric_limits<uint64_t>::max();
+
+  /**
+   * Methods below expect _mutex to be locked
+   */
+  size_t sizeLocked() const
+  {
+    return _values.size();
+  }
+  const TimedValue& frontLocked() const
+  {
+    return _values.front();
+  }
+  const TimedValue& backLocked() const
+  {
+    return _values.back();
+  }
+  typename Container::const_iterator beginLocked() const
+  {
+    return _values.begin();
+  }
+  typename Container::const_iterator endLocked() const
+  {
+    return _values.end();
+  }
+
+  /**
+   * Append a value, dropping the ones out of the window if shrink
+   * is true. Return false if the timestamp is the same as the last one
+   */
+  bool pushLocked(double timestamp, const T& value, bool shrink)
+  {
+    // Check that timestamp is increasing
+    if (sizeLocked() > 0 && timestamp < _values.back().first)
+    {
+      throw std::logic_error("History invalid timestamp");
+    }
+    if (sizeLocked() > 0 && timestamp == _values.back().first)
+    {
+      return false;
+    }
+    _values.push_back(TimedValue(timestamp, value));
+    while (shrink && outOfWindowLocked())
+    {
+      popFrontLocked();
+    }
+    return true;
+  }
+
+  /**
+   * Return true if the first value is out of the window
+   */
+  bool outOfWindowLocked() const
+  {
+    return sizeLocked() > 0 && _values.back().first - _values.front().first > _windowSize;
+  }
+
+  /**
+   * Drop the first value, the history must not be empty
+   */
+  void popFrontLocked()
+  {
+    _values.pop_front();
+    _nbDropped++;
+  }
+
+  /**
+   * Move all the values out of the container without copying
+   * them, only the ones inside the window are copied back
+   */
+  Container takeLocked()
+  {
+    Container values;
+    values.swap(_values);
+    if (values.empty())
+    {
+      return values;
+    }
+    double last = values.back().first;
+    auto first = std::partition_point(values.begin(), values.end(),
+                                      [this, last](const TimedValue& v) { return last - v.first > _windowSize; });
+    _nbDropped += first - values.begin();
+    _values.assign(first, values.end());
+    return values;
+  }
+
+  void clearLocked()
+  {
+    _nbDropped += sizeLocked();
+    _values.clear();
+  }
+
+  /**
+   * Retrieve the points surrounding the given timestamp,
+   * starting the search from the logical index hint and
+   * updating it. Return false if the history is empty
+   */
+  bool bracketLocked(double timestamp, TimedValue& low, TimedValue& up, uint64_t& hint) const
+  {
+    size_t size = sizeLocked();
+    const Container& values = _values;
+    // Degererate failback cases
+    if (size == 0)
+    {
+      return false;
+    }
+    else if (size == 1 || timestamp <= values[0].first)
+    {
+      low = up = values[0];
+      hint = _nbDropped;
+      return true;
+    }
+    else if (timestamp >= values[size - 1].first)
+    {
+      low = up = values[size - 1];
+      hint = _nbDropped + size - 1;
+      return true;
+    }
+
+    size_t indexLow = 0;
+    size_t indexUp = size - 1;
+    // Gallop forward from the hint if it is still in the container
+    if (hint != NoHint && hint >= _nbDropped && hint - _nbDropped < indexUp &&
+        values[hint - _nbDropped].first <= timestamp)
+    {
+      indexLow = hint - _nbDropped;
+      size_t step = 1;
+      while (indexLow + step < indexUp && values[indexLow + step].first <= timestamp)
+      {
+        indexLow += step;
+        step *= 2;
+      }
+      if (indexLow + step < indexUp)
+      {
+        indexUp = indexLow + step;
+      }
+    }
+
+    // Bijection search
+    while (indexUp - indexLow > 1)
+    {
+      size_t indexMiddle = (indexLow + indexUp) / 2;
+      if (values[indexMiddle].first <= timestamp)
+      {
+        indexLow = indexMiddle;
+      }
+      else
+      {
+        indexUp = indexMiddle;
+      }
+    }
+
+    // Retrieve lower and upper bound values
+    low = values[indexLow];
+    up = values[indexUp];
+    hint = _nbDropped + indexLow;
+    return true;
+  }
+
+  /**
+   * Retrieve the two points surrounding the given timestamp in
+   * points[1] and points[2] (see bracketLocked) along with their
+   * outer neighbours in points[0] and points[3]. Missing neighbours
+   * are replaced by the closest bracketing point
+   */
+  bool neighboursLocked(double timestamp, TimedValue points[4], uint64_t& hint) const
+  {
+    if (!bracketLocked(timestamp, points[1], points[2], hint))
+    {
+      return false;
+    }
+    size_t index = hint - _nbDropped;
+    const Container& values = _values;
+    bool inside = points[1].first != points[2].first;
+    points[0] = inside && index > 0 ? values[index - 1] : points[1];
+    points[3] = inside && index + 2 < sizeLocked() ? values[index + 2] : points[2];
+    return true;
+  }
+
+  /**
+   * Mutex for concurent access
+   */
+  mutable std::mutex _mutex;
+
+  /**
+   * Rolling buffer size in timestamp
+   */
+  double _windowSize;
+
+  Interpolator _interpolator;
+
+  /**
+   * Values container indexed by their timestamp
+   */
+  Container _values;
+
+  /**
+   * Number of values removed from the front,
+   * so that _nbDropped + i is the logical index
+   * of the i-th valid value
+   */
+  uint64_t _nbDropped;
+};
+
+}  // namespace starkit_utils
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "starkit_utils/timing/benchmark.h"
+#include "starkit_utils/timing/perf_counters.h"
+#include "starkit_utils/timing/tsc_clock.h"
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace starkit_utils
+{
+/**
+ * Statistical micro benchmark harness built on Benchmark
+ *
+ * run() warms the function up, calibrates the number of iterations
+ * per sample to a target duration and measures repeated samples, each
+ * one as a session of a Benchmark named after the benchmark (so that
+ * traces apply), with the performance counters of the thread read
+ * around it. Results are reported with their median and median
+ * absolute deviation (MAD) and written in the csv schema of
+ * Benchmark::printCSVHeader, with an extra mad column.
+ *
+ * compare() reads two such csv runs and flags significant changes.
+ */
+namespace bench
+{
+/**
+ * Prevent the compiler from optimizing away the computation of value
+ */
+template <typename T>
+inline void DoNotOptimize(T const& value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Force pending memory writes to be considered visible
+ */
+inline void ClobberMemory()
+{
+  asm volatile("" : : : "memory");
+}
+
+struct Options
+{
+  /**
+   * Duration during which the function is run before measures [s]
+   */
+  double warmupTime = 0.1;
+
+  /**
+   * Target duration of a sample [s]
+   */
+  double sampleTime = 0.01;
+
+  int nbSamples = 30;
+
+  uint64_t maxIterationsPerSample = uint64_t(1) << 32;
+};
+
+struct Result
+{
+  std::string name;
+  uint64_t iterationsPerSample;
+
+  /**
+   * Time per iteration of each sample [s]
+   */
+  std::vector<double> samples;
+
+  /**
+   * Median and median absolute deviation of samples [s]
+   */
+  double median;
+  double mad;
+
+  /**
+   * Percentile of samples (nearest rank), ratio in [0, 1]
+   */
+  double percentile(double ratio) const;
+
+  /**
+   * Average performance counters per iteration, NaN if unavailable
+   * (see Benchmark::enableCounters)
+   */
+  std::array<double, PerfCounters::NbCounters> counters;
+};
+
+/**
+ * Number of iterations of the next calibration round of run, given
+ * the duration of the current one [s]
+ */
+uint64_t nextIterations(uint64_t nbIterations, double elapsed, const Options& options);
+
+/**
+ * Measures of the samples of run. The performance counters are read
+ * around each sample, so that they only count the calling thread
+ * during this run
+ */
+class Sampler
+{
+public:
+  Sampler(const std::string& name, uint64_t nbIterations);
+
+  const std::string* getInternedName() const;
+
+  /**
+   * Mark the start and the end of a sample, to be called inside the
+   * scope of the sample benchmark
+   */
+  void start();
+  void stop();
+
+  /**
+   * Summarize the samples, printing a summary line to log if not NULL
+   */
+  Result finish(std::ostream* log);
+
+private:
+  Result result;
+  const std::string* internedName;
+  uint64_t nbIterations;
+
+  uint64_t startTicks;
+  bool counted;
+  PerfCounters::Values startCounters;
+  /**
+   * Total of the counter deltas over the counted samples
+   */
+  PerfCounters::Values counterTotals;
+  int nbCountedSamples;
+  uint32_t countersMask;
+};
+
+/**
+ * Benchmark fn, printing a summary line to log if not NULL. fn is
+ * called directly so that the measures do not include an indirect call
+ */
+template <typename Fn>
+Result run(const std::string& name, Fn&& fn, const Options& options = Options(), std::ostream* log = &std::cerr)
+{
+  // Warmup
+  uint64_t start = TscClock::now();
+  do
+  {
+    fn();
+  } while (TscClock::toSeconds(TscClock::now() - start) < options.warmupTime);
+
+  // Calibration of the number of iterations per sample
+  uint64_t nbIterations = 1;
+  while (nbIterations < options.maxIterationsPerSample)
+  {
+    start = TscClock::now();
+    for (uint64_t i = 0; i < nbIterations; i++)
+    {
+      fn();
+    }
+    double elapsed = TscClock::toSeconds(TscClock::now() - start);
+    if (elapsed >= options.sampleTime)
+    {
+      break;
+    }
+    nbIterations = nextIterations(nbIterations, elapsed, options);
+  }
+
+  // Samples, each one is a session of the benchmark named after the function
+  Sampler sampler(name, nbIterations);
+  for (int sample = 0; sample < options.nbSamples; sample++)
+  {
+    BenchmarkScope scope(sampler.getInternedName());
+    sampler.start();
+    for (uint64_t i = 0; i < nbIterations; i++)
+    {
+      fn();
+    }
+    sampler.stop();
+  }
+  return sampler.finish(log);
+}
+
+/**
+ * Write results in the csv schema of Benchmark::printCSVHeader: one
+ * root row (depth 0) per result, time is the total measured time,
+ * iterations the total number of iterations and percentiles are
+ * those of the time per iteration. A last mad column holds the
+ * median absolute deviation of the time per iteration
+ */
+void writeCSV(std::ostream& out, const std::vector<Result>& results);
+
+struct Comparison
+{
+  std::string name;
+  /**
+   * Median time per iteration [s]
+   */
+  double before;
+  double after;
+
+  /**
+   * after / before
+   */
+  double ratio;
+
+  /**
+   * The change is larger than the threshold and than the noise of both
+   * runs
+   */
+  bool significant;
+  bool regression;
+};
+
+/**
+ * Compare the rows with the same name in two csv files written by
+ * writeCSV. A change is significant when the relative change of
+ * the median exceeds threshold and the absolute change exceeds
+ * nbSigmas times the noise of the noisiest run. The noise is estimated
+ * as 1.4826 * MAD when both files have a mad column. Files written by
+ * Benchmark::printCSV fall back to (p90 - p50) / 1.28, which assumes a
+ * normal distribution and overestimates the noise of right-skewed
+ * timings. Throws a runtime_error on invalid files
+ */
+std::vector<Comparison> compare(std::istream& before, std::istream& after, double threshold = 0.05,
+                                double nbSigmas = 3);
+
+/**
+ * Print comparisons as a table, return the number of regressions
+ */
+int printComparisons(std::ostream& out, const std::vector<Comparison>& comparisons);
+
+}  // namespace bench
+}  // namespace starkit_utils
@@ -1,43 +1,207 @@
 #pragma once
 
+#include "starkit_utils/timing/latency_histogram.h"
+#include "starkit_utils/timing/perf_counters.h"
 #include "starkit_utils/timing/time_stamp.h"
+#include "starkit_utils/timing/tsc_clock.h"
 
+#include <atomic>
 #include <chrono>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <stdexcept>
 #include <iostream>
+#include <vector>
 // TODO: create an example tests for this class
 
 /**
- * Currently this 'Benchmark method' is not thread-safe.
+ * Each thread builds its own benchmark tree: the current benchmark is
+ * thread-local and open/close never take a lock.
+ *
+ * When a root benchmark is closed, its tree is merged by path into a
+ * pending tree of its thread, handed over with atomic exchanges to a
+ * process-wide registry. The registry can then be printed merged over
+ * all threads or per thread, at any time and from any thread, without
+ * ever blocking the closing threads.
+ *
+ * Optionally, each open and close can also be recorded as a begin/end
+ * event in a preallocated per-thread buffer and exported as a Chrome
+ * Trace Event JSON file (loads in Perfetto or chrome://tracing).
+ *
+ * Performance counters (cycles, instructions, cache and branch misses,
+ * context switches) can also be measured per benchmark, see
+ * enableCounters.
+ *
+ * Long running processes can publish periodic snapshots of the times
+ * and iterations since the previous snapshot without closing their
+ * trees, see startSnapshots and BenchmarkSnapshotWriter.
  */
 namespace starkit_utils
 {
 class Benchmark
 {
+public:
+  /**
+   * Time and iterations of a benchmark since the previous snapshot
+   */
+  struct SnapshotEntry
+  {
+    const std::string* name;
+    /**
+     * NULL for root benchmarks
+     */
+    const std::string* fatherName;
+    int depth;
+    uint64_t ticks;
+    int nbIterations;
+  };
+
+  struct Snapshot
+  {
+    std::string threadName;
+    /**
+     * Period covered by the snapshot [TscClock ticks]
+     */
+    uint64_t startTicks;
+    uint64_t endTicks;
+    /**
+     * Number of benchmarks which did not fit in the snapshot
+     */
+    size_t nbTruncated;
+    std::vector<SnapshotEntry> entries;
+  };
+
 private:
+  /**
+   * Accumulated trees of a thread, defined in benchmark.cpp
+   */
+  struct ThreadRecord;
+
+  /**
+   * Nodes and closed root trees of a thread, defined in benchmark.cpp
+   */
+  struct Arena;
+
   /* Static variables */
-  static Benchmark* current;
+  static thread_local Benchmark* current;
+  static thread_local std::shared_ptr<ThreadRecord> threadRecord;
+  static std::mutex registryMutex;
+  static std::vector<std::shared_ptr<ThreadRecord>> registry;
+
+  /**
+   * Event recording settings, a new generation resets the buffers
+   */
+  static std::atomic<bool> tracing;
+  static std::atomic<size_t> traceCapacity;
+  static std::atomic<uint64_t> traceGeneration;
+
+  /**
+   * Performance counters are read in sessions opened while set
+   */
+  static std::atomic<bool> counting;
+
+  /**
+   * Snapshot settings, a new generation resets the buffers
+   */
+  static std::atomic<bool> snapshotting;
+  static std::atomic<uint64_t> snapshotPeriod;
+  static std::atomic<size_t> snapshotCapacity;
+  static std::atomic<size_t> snapshotNbSlots;
+  static std::atomic<uint64_t> snapshotGeneration;
 
   /* Local variables */
   Benchmark* father;
   std::string name;
-  TimeStamp openingTime;
-  TimeStamp closingTime;
+  /**
+   * Times are measured in TscClock ticks, converted when printing
+   */
+  uint64_t openingTicks;
+  uint64_t closingTicks;
   double elapsedTicks;
   int nbIterations;
+  /**
+   * Duration of each session [ticks]
+   */
+  LatencyHistogram latencies;
+  /**
+   * Interned copy of name, NULL until opened through it or traced
+   */
+  const std::string* internedName;
+  /**
+   * Children opened through interned names, small enough for a linear
+   * scan to beat the map lookup
+   */
+  std::vector<std::pair<const std::string*, Benchmark*>> internedChildren;
   std::map<std::string, Benchmark*> children;
+  /**
+   * True for nodes owned by a thread arena, which owns their children
+   */
+  bool pooled;
+  /**
+   * Counts at the opening of the session, total of the deltas over the
+   * counted sessions and available counters
+   */
+  PerfCounters::Values openingCounters;
+  PerfCounters::Values counterTotals;
+  int nbCountedIterations;
+  uint32_t countersMask;
+  bool countingSession;
+  /**
+   * Ticks and iterations since the previous snapshot
+   */
+  uint64_t snapshotTicks;
+  int snapshotIterations;
 
   static Benchmark* getCurrent();
 
+  static Arena& getArena();
+
+  /**
+   * Counters of the calling thread, opened at first call, NULL if none
+   * is available
+   */
+  static PerfCounters* getThreadCounters();
+
+  /**
+   * Get a node from the arena of the calling thread
+   */
+  static Benchmark* acquire(Benchmark* father, const std::string& name);
+
+  /**
+   * Give node and its descendants back to the arena of the calling thread
+   */
+  static void release(Benchmark* node);
+
+  /**
+   * Return the retained tree of the root benchmark named name, reset,
+   * or a new one
+   */
+  static Benchmark* openRoot(const std::string& name);
+
+  /**
+   * End the session of the current benchmark and return to its father,
+   * return the closed benchmark
+   */
+  static Benchmark* closeCurrent();
+
+  /**
+   * Zero the times and iterations of this node and its descendants,
+   * keeping them allocated
+   */
+  void resetStats();
+
+  /**
+   * A pooled node not opened since its tree was reused
+   */
+  bool isStale() const;
+
   void print(std::ostream& out, int maxDepth = -1);
   void print(std::ostream& out, int depth, int width, int maxDepth = -1);
 
   void printCSV(std::ostream& out, int depth, int maxDepth = -1);
 
-  static void printCSVHeader(std::ostream& out);
-
   // Start a new timing session
   void startSession();
   void endSession();
@@ -45,10 +209,88 @@ private:
   double getTime() const;
   double getSubTime() const;
 
+  /**
+   * Session duration [s] below which lie the given ratio of sessions
+   */
+  double getPercentile(double ratio) const;
+
+  /**
+   * Average count of a counter per counted session, NaN if not available
+   */
+  double getCounterPerIteration(PerfCounters::Counter counter) const;
+
+  /**
+   * Instructions per cycle, NaN if not available
+   */
+  double getIPC() const;
+
+  /**
+   * Add the times and iterations of src and of all its descendants to
+   * the benchmarks with the same path in dst, creating them if needed
+   */
+  static void merge(Benchmark* dst, const Benchmark* src);
+
+  /**
+   * Return the record of the calling thread, registering it if needed
+   */
+  static ThreadRecord& getThreadRecord();
+
+  /**
+   * Copy of the registry, so that the records can be read without
+   * blocking the threads registering meanwhile
+   */
+  static std::vector<std::shared_ptr<ThreadRecord>> getRecords();
+
+  /**
+   * Merge a closed root benchmark into the pending tree of the calling
+   * thread
+   */
+  static void publish(const Benchmark* root);
+
+  /**
+   * Move the pending tree of record into its tree, record mutex must be
+   * held
+   */
+  static void takePending(ThreadRecord& record);
+
+  /**
+   * Record a begin ('B') or end ('E') event of benchmark b if tracing
+   */
+  static void trace(Benchmark* b, char phase, uint64_t ticks);
+
+  /**
+   * Return the interned name of b, interning it if needed
+   */
+  static const std::string* getInternedName(Benchmark* b);
+
+  /**
+   * Publish a snapshot of the trees of the calling thread if its period
+   * is over at given ticks (or anyway if force is set)
+   */
+  static void snapshot(uint64_t ticks, bool force);
+
+  /**
+   * Add the entries of node and its descendants to snapshot, resetting
+   * their snapshot times and iterations
+   */
+  static void fillSnapshot(Benchmark* node, int depth, std::vector<SnapshotEntry>& entries, size_t* nbEntries,
+                           size_t* nbTruncated);
+
+  /**
+   * Return the benchmark at given path ('/' separated names) below
+   * root, NULL if there is none
+   */
+  static const Benchmark* find(const Benchmark* root, const std::string& path);
+
+  /**
+   * Return a new tree holding all the closed root benchmarks of all
+   * threads (or of the threads named threadName if not empty)
+   */
+  static Benchmark* collect(const std::string& threadName = "");
+
 public:
   Benchmark(Benchmark* father, const std::string& name);
   ~Benchmark();
-  // TODO fix memory leak due to destruction of children
 
   /**
    * Open a new benchmark or subBenchmark
@@ -56,6 +298,47 @@ public:
    */
   static void open(const std::string& benchmarkName);
 
+  /**
+   * Return a unique pointer for the given name, to be kept and used as
+   * a static id (see BENCH_SCOPE). Takes a lock, intern names once
+   */
+  static const std::string* intern(const std::string& name);
+
+  /**
+   * Open a benchmark from its interned name, avoiding the construction
+   * of a string and the children map lookup
+   */
+  static void open(const std::string* internedName);
+
+  /**
+   * Close the benchmarks opened since scope, then scope itself. Does
+   * nothing if scope is not open anymore
+   */
+  static void closeScope(const Benchmark* scope);
+
+  /**
+   * Return the current benchmark of the calling thread, NULL if there is none
+   */
+  static Benchmark* getActive();
+
+  /**
+   * Nodes of the calling thread are allocated in an arena. Closed root
+   * trees are kept and reset when a root with the same name is opened
+   * again, so that reopening a known tree does not allocate.
+   *
+   * resetArena gives all the nodes of the calling thread back to its
+   * arena for reuse by other trees. Throws a runtime_error if a
+   * benchmark is open. Memory is freed when the thread exits
+   */
+  static void resetArena();
+
+  /**
+   * Number of nodes allocated in the arena of the calling thread, and
+   * number of those available for reuse
+   */
+  static size_t getNbArenaNodes();
+  static size_t getNbFreeArenaNodes();
+
   /**
    * Close current benchmark or subBenchmark and return to previous context
    * if needed
@@ -93,5 +376,177 @@ public:
    * parameter
    */
   static double closeCSV(std::ostream& out, bool header, int detailLevel = -1);
+
+  /**
+   * Print the csv header of closeCSV and printMergedCSV
+   */
+  static void printCSVHeader(std::ostream& out);
+
+  /**
+   * Set the name of the calling thread in the registry, threads are
+   * named thread_<n> by default (in order of their first root close)
+   */
+  static void setThreadName(const std::string& threadName);
+
+  /**
+   * Return the names of the threads which closed a root benchmark
+   */
+  static std::vector<std::string> getThreadNames();
+
+  /**
+   * Print the closed benchmarks of all threads, merged by path
+   */
+  static void printMerged(std::ostream& out = std::cout, int detailLevel = -1);
+
+  /**
+   * Print the closed benchmarks of each thread separately
+   */
+  static void printThreads(std::ostream& out = std::cout, int detailLevel = -1);
+
+  /**
+   * Print the closed benchmarks of all threads, merged by path, as csv
+   */
+  static void printMergedCSV(std::ostream& out, bool header, int detailLevel = -1);
+
+  /**
+   * Get the total time [s] and number of iterations of the benchmark at
+   * given path ('/' separated names from the root, e.g. "loop/vision"),
+   * merged over all threads or restricted to the threads named
+   * threadName. Returns false if no such benchmark was closed
+   */
+  static bool getStats(const std::string& path, double* time, int* nbIterations,
+                       const std::string& threadName = "");
+
+  /**
+   * Forget all the benchmarks published by all threads
+   */
+  static void clearRegistry();
+
+  /**
+   * Read performance counters at the opening and closing of sessions
+   * (one read syscall each). print shows IPC and counts per iteration
+   * and printCSV adds columns ipc,llc_misses,branch_misses,
+   * context_switches (per iteration) while enabled. Threads where perf
+   * is unavailable only measure wall time
+   */
+  static void enableCounters(bool enable = true);
+  static bool areCountersEnabled();
+
+  /**
+   * Return true if the calling thread can read at least one counter
+   */
+  static bool hasCounters();
+
+  /**
+   * Read the counters of the calling thread while counters are enabled,
+   * returns false if none is available. Bit i of mask is set if
+   * counter i is available
+   */
+  static bool readCounters(PerfCounters::Values* values, uint32_t* mask = NULL);
+
+  /**
+   * Get the average counts per session of the benchmark at given path
+   * (see getStats), NaN for unavailable counters. Returns false if it
+   * has no counted session
+   */
+  static bool getCounterStats(const std::string& path, std::array<double, PerfCounters::NbCounters>* perIteration,
+                              const std::string& threadName = "");
+
+  /**
+   * Start recording open and close events, discarding previous
+   * events. Each thread preallocates room for nbEventsPerThread events
+   * at its first event, events are dropped once it is full
+   */
+  static void startTracing(size_t nbEventsPerThread = 1 << 16);
+
+  /**
+   * Stop recording events, recorded events are kept
+   */
+  static void stopTracing();
+  static bool isTracing();
+
+  /**
+   * Number of events dropped because of full buffers since tracing started
+   */
+  static uint64_t getNbDroppedEvents();
+
+  /**
+   * Write the recorded events of all threads in Chrome Trace Event
+   * JSON format. May be called while tracing
+   */
+  static void writeTrace(std::ostream& out);
+  static void writeTrace(const std::string& path);
+
+  /**
+   * Publish, from each thread, a snapshot of the time and iterations of
+   * its benchmarks since its previous snapshot, every period [s].
+   *
+   * The check is done when closing a benchmark, so a thread publishes
+   * at its first close after the end of the period. A benchmark
+   * contributes to the snapshot of the period in which it was closed.
+   * Snapshots are copied in preallocated per-thread rings of nbSlots
+   * snapshots of up to nbEntries benchmarks, without locking,
+   * allocating or formatting. When the ring is full, publishing is
+   * delayed to the next period (see getNbDelayedSnapshots)
+   */
+  static void startSnapshots(double period, size_t nbEntries = 256, size_t nbSlots = 16);
+  static void stopSnapshots();
+  static bool isSnapshotting();
+
+  /**
+   * Publish a snapshot of the calling thread now, e.g. before it exits
+   */
+  static void publishSnapshot();
+
+  /**
+   * Append the published snapshots of all threads to snapshots and
+   * remove them from the rings, return the number of snapshots popped
+   */
+  static size_t popSnapshots(std::vector<Snapshot>* snapshots);
+
+  /**
+   * Number of snapshots delayed because of full rings since snapshots
+   * started
+   */
+  static uint64_t getNbDelayedSnapshots();
+};
+
+/**
+ * Opens a benchmark on construction and closes it on destruction,
+ * including on stack unwinding. See BENCH_SCOPE
+ */
+class BenchmarkScope
+{
+public:
+  BenchmarkScope(const std::string* internedName) : scope(NULL)
+  {
+    Benchmark::open(internedName);
+    scope = Benchmark::getActive();
+  }
+
+  ~BenchmarkScope()
+  {
+    Benchmark::closeScope(scope);
+  }
+
+  BenchmarkScope(const BenchmarkScope& other) = delete;
+  BenchmarkScope& operator=(const BenchmarkScope& other) = delete;
+
+private:
+  const Benchmark* scope;
 };
 }  // namespace starkit_utils
+
+#define STARKIT_UTILS_BENCH_CONCAT_(a, b) a##b
+#define STARKIT_UTILS_BENCH_CONCAT(a, b) STARKIT_UTILS_BENCH_CONCAT_(a, b)
+
+/**
+ * Benchmark the rest of the enclosing scope, e.g.
+ *   void Robot::tick() { BENCH_SCOPE("tick"); ... }
+ * The name is interned once per call site
+ */
+#define BENCH_SCOPE(name)                                                                                              \
+  static const std::string* STARKIT_UTILS_BENCH_CONCAT(benchScopeName_, __LINE__) =                                    \
+      starkit_utils::Benchmark::intern(name);                                                                          \
+  starkit_utils::BenchmarkScope STARKIT_UTILS_BENCH_CONCAT(benchScope_, __LINE__)(                                     \
+      STARKIT_UTILS_BENCH_CONCAT(benchScopeName_, __LINE__))
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "starkit_utils/timing/benchmark.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace starkit_utils
+{
+class UDPBroadcast;
+
+/**
+ * Pops the snapshots published by Benchmark::startSnapshots from a
+ * background thread and writes them as csv lines, to a stream or a file
+ * or broadcasted as UDP messages (one message with a header per
+ * snapshot). Formatting and I/O never happen in the measured threads.
+ */
+class BenchmarkSnapshotWriter
+{
+public:
+  /**
+   * Write to out, which has to outlive the writer. Snapshots are popped
+   * every pollPeriod [s]
+   */
+  BenchmarkSnapshotWriter(std::ostream& out, double pollPeriod = 0.1);
+
+  /**
+   * Write to the file at path, throws a runtime_error if it can not be
+   * opened
+   */
+  BenchmarkSnapshotWriter(const std::string& path, double pollPeriod = 0.1);
+
+  /**
+   * Broadcast on given UDP port
+   */
+  BenchmarkSnapshotWriter(int port, double pollPeriod = 0.1);
+
+  /**
+   * Stop the thread after writing the pending snapshots
+   */
+  ~BenchmarkSnapshotWriter();
+
+  BenchmarkSnapshotWriter(const BenchmarkSnapshotWriter& other) = delete;
+  BenchmarkSnapshotWriter& operator=(const BenchmarkSnapshotWriter& other) = delete;
+
+  /**
+   * Number of snapshots written so far
+   */
+  size_t getNbWritten() const;
+
+  /**
+   * Csv format: timestamp [s] and period [s] of the snapshot, then for
+   * each benchmark the time [s] and iterations since the previous
+   * snapshot. Truncated snapshots have a last line named "truncated"
+   * with the number of missing benchmarks as iterations
+   */
+  static void printCSVHeader(std::ostream& out);
+  static void printCSV(std::ostream& out, const Benchmark::Snapshot& snapshot);
+
+private:
+  void start();
+  void run();
+
+  /**
+   * Write and forget the popped snapshots
+   */
+  void write();
+
+  std::ostream* out;
+  std::unique_ptr<std::ofstream> file;
+  std::unique_ptr<UDPBroadcast> udp;
+  double pollPeriod;
+
+  std::vector<Benchmark::Snapshot> snapshots;
+  std::atomic<size_t> nbWritten;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool stopped;
+  std::thread thread;
+};
+}  // namespace starkit_utils
@@ -1,7 +1,11 @@
 #pragma once
 
+#include "starkit_utils/timing/latency_histogram.h"
 #include "starkit_utils/timing/time_stamp.h"
 
+#include <cstdint>
+#include <iostream>
+
 namespace starkit_utils
 {
 /**
@@ -10,6 +14,11 @@ namespace starkit_utils
  * Implement ticked behaviour
  * with stats and elapsed
  * time computation.
+ *
+ * Execution durations and periods between ticks are recorded in
+ * histograms (~3% precision) for tail latencies, and executions can be
+ * checked against a deadline. Updating the stats is O(1) and never
+ * allocates.
  */
 class ElapseTick
 {
@@ -37,6 +46,46 @@ public:
   double avgTime;
   double maxTime;
 
+  /**
+   * Deadline miss stats, a miss is a ticked execution longer than the
+   * deadline. lastMiss is the end of the last missed execution
+   */
+  uint64_t nbMisses;
+  uint64_t missStreak;
+  uint64_t longestMissStreak;
+  TimeStamp lastMiss;
+
+  /**
+   * Set the maximum execution duration of a tick [ms], 0 disables
+   * deadline checks
+   */
+  void setDeadline(double deadlineMs);
+  double getDeadline() const;
+
+  /**
+   * Duration [ms] below which lie given ratio (in [0, 1]) of the ticked
+   * executions, or of the periods between calls to tick. 0 if empty
+   */
+  double getTimePercentile(double ratio) const;
+  double getPeriodPercentile(double ratio) const;
+
+  /**
+   * Histograms of the ticked execution durations and of the periods
+   * between calls to tick [ns]
+   */
+  const LatencyHistogram& getTimes() const;
+  const LatencyHistogram& getPeriods() const;
+
+  /**
+   * Forget all the stats
+   */
+  void resetStats();
+
+  /**
+   * Print a one line summary of the stats
+   */
+  void printStats(std::ostream& out = std::cout) const;
+
 protected:
   /**
    * Ticked implementation
@@ -51,6 +100,20 @@ private:
    * Elapsed computation
    */
   TimeStamp lastTimestamp;
+
+  /**
+   * False until the first call to tick, the elapsed time since the
+   * construction is not a period
+   */
+  bool hasTicked;
+
+  /**
+   * Deadline [ns], 0 if disabled
+   */
+  uint64_t deadline;
+
+  LatencyHistogram times;
+  LatencyHistogram periods;
 };
 
 }  // namespace starkit_utils
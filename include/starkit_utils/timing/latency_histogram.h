@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace starkit_utils
+{
+/**
+ * LatencyHistogram
+ *
+ * HDR-style histogram of non negative integer durations (typically
+ * clock ticks). Values below 16 have their own bucket, above each
+ * power of two is split in 16 buckets, so that percentiles are known
+ * within 1/32 (~3%) of their value over the whole 64 bits range.
+ *
+ * Buckets are allocated on the first record (or by reserve), recording
+ * is then O(1) and allocation-free.
+ */
+class LatencyHistogram
+{
+public:
+  /**
+   * Number of buckets per power of two
+   */
+  static constexpr int SubBuckets = 16;
+  static constexpr size_t NbBuckets = (64 - 3) * SubBuckets;
+
+  LatencyHistogram();
+  LatencyHistogram(const LatencyHistogram& other);
+  LatencyHistogram& operator=(const LatencyHistogram& other);
+
+  void record(uint64_t value);
+
+  /**
+   * Allocate the buckets now, so that recording never allocates
+   */
+  void reserve();
+
+  /**
+   * Add all the values recorded by other
+   */
+  void merge(const LatencyHistogram& other);
+
+  /**
+   * Forget recorded values, buckets are kept allocated. Only the
+   * buckets between min and max are zeroed
+   */
+  void clear();
+
+  uint64_t count() const;
+  uint64_t min() const;
+  uint64_t max() const;
+
+  /**
+   * Value below which lie given ratio (in [0, 1]) of the recorded
+   * values, the middle of its bucket clamped to [min, max].
+   * Returns 0 if empty
+   */
+  double percentile(double ratio) const;
+
+  /**
+   * Bucket of a value and lowest value of a bucket
+   */
+  static size_t bucketIndex(uint64_t value);
+  static uint64_t bucketLowest(size_t index);
+
+private:
+  std::unique_ptr<uint64_t[]> _buckets;
+  uint64_t _count;
+  uint64_t _min;
+  uint64_t _max;
+};
+
+}  // namespace starkit_utils
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace starkit_utils
+{
+/**
+ * PerfCounters
+ *
+ * Hardware and software performance counters of the calling thread,
+ * opened with perf_event_open as a single group read by one syscall.
+ * Counters which can not be opened (no PMU, perf_event_paranoid,
+ * non Linux system) are reported as unavailable and read as 0.
+ *
+ * Counts are not scaled if the kernel multiplexes the counters.
+ */
+class PerfCounters
+{
+public:
+  enum Counter
+  {
+    Cycles = 0,
+    Instructions,
+    LLCMisses,
+    BranchMisses,
+    ContextSwitches,
+    NbCounters
+  };
+
+  typedef std::array<uint64_t, NbCounters> Values;
+
+  /**
+   * Open the counters for the calling thread, they count events
+   * of this thread only
+   */
+  PerfCounters();
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters& other) = delete;
+  PerfCounters& operator=(const PerfCounters& other) = delete;
+
+  /**
+   * Return true if at least one (resp. the given) counter is available
+   */
+  bool isAvailable() const;
+  bool isAvailable(Counter counter) const;
+
+  /**
+   * Bit i is set if counter i is available
+   */
+  uint32_t getAvailableMask() const;
+
+  /**
+   * Read the current counts, 0 for unavailable counters
+   */
+  void read(Values& values) const;
+
+  static std::string getName(Counter counter);
+
+private:
+  /**
+   * Descriptors of the counters, -1 if unavailable
+   */
+  std::array<int, NbCounters> _fds;
+
+  /**
+   * Descriptor of the group leader, -1 if no counter is available
+   */
+  int _leader;
+
+  /**
+   * Available counters in group order
+   */
+  std::array<int, NbCounters> _order;
+  int _nbOpened;
+};
+
+}  // namespace starkit_utils
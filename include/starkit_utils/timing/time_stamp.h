@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <string>
 
 namespace starkit_utils
@@ -14,6 +15,11 @@ public:
 
   static TimeStamp fromMS(unsigned long msSinceEpoch);
 
+  /**
+   * Convert raw ticks read with TscClock::now()
+   */
+  static TimeStamp fromTicks(uint64_t ticks);
+
   double getTimeSec() const;
   double getTimeMS() const;
 };
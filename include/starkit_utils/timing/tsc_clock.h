@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define STARKIT_UTILS_HAS_RDTSC 1
+#else
+#define STARKIT_UTILS_HAS_RDTSC 0
+#endif
+
+namespace starkit_utils
+{
+/**
+ * TscClock
+ *
+ * Low overhead clock reading the time stamp counter (rdtsc) when the
+ * CPU has an invariant TSC (constant rate, not stopped in deep
+ * C-states), and steady_clock nanoseconds otherwise.
+ *
+ * now() only returns raw ticks: conversion to seconds or to
+ * steady_clock time points is meant to be deferred to print time. The
+ * TSC frequency is calibrated against steady_clock at the first
+ * conversion, over at least CalibrationDuration since the first read
+ * (done when the library is loaded).
+ */
+class TscClock
+{
+public:
+  /**
+   * Minimal duration of the calibration [s]
+   */
+  static constexpr double CalibrationDuration = 0.01;
+
+  /**
+   * Current raw ticks
+   */
+  static inline uint64_t now()
+  {
+#if STARKIT_UTILS_HAS_RDTSC
+    if (usesTsc())
+    {
+      return __rdtsc();
+    }
+#endif
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+  }
+
+  /**
+   * Return true if ticks are read from the TSC, false if they
+   * come from steady_clock
+   */
+  static inline bool usesTsc()
+  {
+    static const bool tsc = initialize();
+    return tsc;
+  }
+
+  /**
+   * Return true if the CPU reports an invariant TSC
+   */
+  static bool hasInvariantTsc();
+
+  /**
+   * Number of ticks per second, calibrates the TSC if needed
+   */
+  static double getFrequency();
+
+  /**
+   * Convert a number of ticks to seconds
+   */
+  static double toSeconds(double ticks);
+
+  /**
+   * Convert ticks read with now() to a steady_clock time point
+   */
+  static std::chrono::steady_clock::time_point toSteady(uint64_t ticks);
+
+private:
+  /**
+   * Choose the source and take the calibration reference
+   */
+  static bool initialize();
+};
+
+}  // namespace starkit_utils
@@ -1,4 +1,13 @@
 set(SOURCES
     history.cpp
+    history_aggregates.cpp
+    history_codec.cpp
+    history_collection.cpp
+    history_loader.cpp
+    history_log_writer.cpp
+    history_pyramid.cpp
+    history_replayer.cpp
+    history_ring.cpp
+    mapped_history.cpp
+    shared_history.cpp
 )
-
@@ -1,70 +1,103 @@
 #include <starkit_utils/angle.h>
 #include "starkit_utils/history/history.h"
+#include "starkit_utils/history/history_codec.h"
+#include "starkit_utils/history/history_log_writer.h"
 #include "starkit_utils/util.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 namespace starkit_utils
 {
-History::History(double window) : _mutex(), _isLogging(false), _startLoggingTime(-1.0), _windowSize(window), _values()
+History::History(double window) : TypedHistory<double>(window), _isLogging(false), _startLoggingTime(-1.0)
 {
 }
 
-void History::setWindowSize(double window)
+History::History(double window, size_t ringCapacity)
+  : TypedHistory<double>(window), _isLogging(false), _startLoggingTime(-1.0), _ring(new HistoryRing(ringCapacity, window))
 {
-  _windowSize = window;
 }
 
-size_t History::size() const
+bool History::isLockFree() const
 {
-  return _values.size();
+  return _ring != nullptr;
 }
 
-const std::pair<double, double>& History::front() const
+void History::checkNotLockFree(const std::string& operation) const
 {
-  if (_values.size() == 0)
+  if (_ring)
   {
-    static std::pair<double, double> zero = { 0.0, 0.0 };
-    return zero;
+    throw std::logic_error(DEBUG_INFO + " " + operation + " is not available on lock-free History");
   }
-  else
+}
+
+void History::setWindowSize(double window)
+{
+  TypedHistory<double>::setWindowSize(window);
+  if (_ring)
   {
-    return _values.front();
+    _ring->setWindowSize(window);
   }
 }
-const std::pair<double, double>& History::back() const
+
+size_t History::size() const
 {
-  if (_values.size() == 0)
+  if (_ring)
   {
-    static std::pair<double, double> zero = { 0.0, 0.0 };
-    return zero;
+    return _ring->size();
   }
-  else
+  return TypedHistory<double>::size();
+}
+
+History::TimedValue History::front() const
+{
+  if (_ring)
   {
-    return _values.back();
+    return _ring->front();
   }
+  return TypedHistory<double>::front();
+}
+History::TimedValue History::back() const
+{
+  if (_ring)
+  {
+    return _ring->back();
+  }
+  return TypedHistory<double>::back();
 }
 
 void History::pushValue(double timestamp, double value)
 {
-  // Lock
-  _mutex.lock();
-  // Check that timestamp is increasing
-  if (_values.size() > 0 && timestamp < _values.back().first)
+  // Lock-free mode: no lock, no allocation
+  if (_ring)
   {
-    _mutex.unlock();
-    throw std::logic_error("History invalid timestamp");
+    _ring->push(timestamp, value);
+    return;
   }
-  if (_values.size() > 0 && timestamp == _values.back().first)
+  std::lock_guard<std::mutex> lock(_mutex);
+  // Insert the value, shrinking the queue if not in logging mode
+  if (!pushLocked(timestamp, value, !_isLogging && !_aggregates))
   {
-    _mutex.unlock();
     return;
   }
-  std::pair<double, double> entry(timestamp, value);
-  // Insert the value
-  _values.push_back(entry);
-  // Shrink the queue if not in logging mode
-  while (!_isLogging && !_values.empty() && (_values.back().first - _values.front().first > _windowSize))
+  if (_aggregates)
   {
-    _values.pop_front();
+    _aggregates->push(value);
+    // Shrink here to update aggregates with the dropped values
+    while (!_isLogging && outOfWindowLocked())
+    {
+      _aggregates->pop(frontLocked().second);
+      popFrontLocked();
+    }
+  }
+  if (_pyramid)
+  {
+    _pyramid->push(timestamp, value);
+    if (!_isLogging)
+    {
+      _pyramid->dropBefore(frontLocked().first);
+    }
   }
   // Set the startLoggingTime to the first
   // data timestampt pushed after startLogging() is called
@@ -75,63 +108,123 @@ void History::pushValue(double timestamp, double value)
   // Write new entries for all named sessions
   for (auto& namedLog : _activeLogs)
   {
-    namedLog.second->push_back(entry);
+    namedLog.second->push_back(TimedValue(timestamp, value));
   }
-  // Unlock
-  _mutex.unlock();
 }
 
 double History::interpolate(double timestamp, History::ValueType valueType) const
 {
-  // Lock
-  _mutex.lock();
+  uint64_t hint = NoHint;
+  TimedValue low, up;
+  if (!bracket(timestamp, low, up, hint))
+  {
+    return 0.0;
+  }
+  return interpolateBracket(low, up, timestamp, valueType);
+}
 
-  // Degererate failback cases
-  if (_values.size() == 0)
+double History::interpolate(double timestamp, Kernel kernel, ValueType valueType) const
+{
+  if (kernel == Linear)
+  {
+    return interpolate(timestamp, valueType);
+  }
+  uint64_t hint = NoHint;
+  TimedValue points[4];
+  if (!neighbours(timestamp, points, hint))
   {
-    _mutex.unlock();
     return 0.0;
   }
-  else if (_values.size() == 1)
+  return interpolateNeighbours(points, timestamp, kernel, valueType);
+}
+
+void History::interpolateBatch(const double* timestamps, size_t n, double* out, ValueType valueType) const
+{
+  uint64_t hint = NoHint;
+  TimedValue low, up;
+  // Lock-free mode: no lock to factorize
+  if (_ring)
   {
-    _mutex.unlock();
-    return _values.front().second;
+    for (size_t i = 0; i < n; i++)
+    {
+      out[i] = _ring->bracket(timestamps[i], low, up, &hint) ? interpolateBracket(low, up, timestamps[i], valueType) :
+                                                                 0.0;
+    }
+    return;
   }
-  else if (timestamp <= _values.front().first)
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (size_t i = 0; i < n; i++)
   {
-    _mutex.unlock();
-    return _values.front().second;
+    out[i] = bracketLocked(timestamps[i], low, up, hint) ? interpolateBracket(low, up, timestamps[i], valueType) : 0.0;
   }
-  else if (timestamp >= _values.back().first)
+}
+
+History::Cursor::Cursor(const History& history) : _history(&history), _index(NoHint)
+{
+}
+
+double History::Cursor::interpolate(double timestamp, ValueType valueType)
+{
+  TimedValue low, up;
+  if (!_history->bracket(timestamp, low, up, _index))
   {
-    _mutex.unlock();
-    return _values.back().second;
+    return 0.0;
   }
+  return interpolateBracket(low, up, timestamp, valueType);
+}
 
-  // Bijection search
-  size_t indexLow = 0;
-  size_t indexUp = _values.size() - 1;
-  while (indexUp - indexLow > 1)
+double History::Cursor::interpolate(double timestamp, Kernel kernel, ValueType valueType)
+{
+  TimedValue points[4];
+  if (!_history->neighbours(timestamp, points, _index))
   {
-    size_t indexMiddle = (indexLow + indexUp) / 2;
-    if (_values[indexMiddle].first <= timestamp)
-    {
-      indexLow = indexMiddle;
-    }
-    else
-    {
-      indexUp = indexMiddle;
-    }
+    return 0.0;
   }
+  return interpolateNeighbours(points, timestamp, kernel, valueType);
+}
 
-  // Retrieve lower and upper bound values
-  double tsLow = _values[indexLow].first;
-  double valLow = _values[indexLow].second;
-  double tsUp = _values[indexUp].first;
-  double valUp = _values[indexUp].second;
+void History::Cursor::reset()
+{
+  _index = NoHint;
+}
 
-  // Unlock
-  _mutex.unlock();
+bool History::bracket(double timestamp, TimedValue& low, TimedValue& up, uint64_t& hint) const
+{
+  // Lock-free mode: the ring provides a consistent bracket
+  if (_ring)
+  {
+    return _ring->bracket(timestamp, low, up, &hint);
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  return bracketLocked(timestamp, low, up, hint);
+}
+
+bool History::neighbours(double timestamp, TimedValue points[4], uint64_t& hint) const
+{
+  if (_ring)
+  {
+    return _ring->neighbours(timestamp, points, &hint);
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  return neighboursLocked(timestamp, points, hint);
+}
+
+double History::interpolateBracket(const TimedValue& low, const TimedValue& up, double timestamp,
+                                   ValueType valueType)
+{
+  if (low.first == up.first)
+  {
+    return low.second;
+  }
+  return blend(low, up, timestamp, valueType);
+}
+
+double History::blend(const TimedValue& low, const TimedValue& up, double timestamp, ValueType valueType)
+{
+  double tsLow = low.first;
+  double valLow = low.second;
+  double tsUp = up.first;
+  double valUp = up.second;
 
   // Weights
   double wLow = (tsUp - timestamp) / (tsUp - tsLow);
@@ -156,47 +249,186 @@ double History::interpolate(double timestamp, History::ValueType valueType) cons
   }
 }
 
+/**
+ * Tangent at the junction of two segments of given slopes and
+ * durations preserving monotonicity (Fritsch-Carlson with the
+ * weighted harmonic mean of Fritsch-Butland)
+ */
+static double monotoneTangent(double slopeLeft, double slopeRight, double durationLeft, double durationRight)
+{
+  if (slopeLeft * slopeRight <= 0.0)
+  {
+    return 0.0;
+  }
+  return 3.0 * (durationLeft + durationRight) /
+         ((2.0 * durationRight + durationLeft) / slopeLeft + (durationRight + 2.0 * durationLeft) / slopeRight);
+}
+
+double History::interpolateNeighbours(const TimedValue points[4], double timestamp, Kernel kernel,
+                                      ValueType valueType)
+{
+  if (points[1].first == points[2].first)
+  {
+    return points[1].second;
+  }
+  if (kernel == Linear)
+  {
+    return blend(points[1], points[2], timestamp, valueType);
+  }
+  if (valueType != Number && valueType != AngleRad)
+  {
+    throw std::logic_error("History unknown value type for interpolate");
+  }
+
+  // Values, unwrapped around the lower point for angles
+  double values[4];
+  values[1] = points[1].second;
+  values[0] = points[0].second;
+  values[2] = points[2].second;
+  values[3] = points[3].second;
+  if (valueType == AngleRad)
+  {
+    values[0] = values[1] + normalizeRad(values[0] - values[1]);
+    values[2] = values[1] + normalizeRad(values[2] - values[1]);
+    values[3] = values[2] + normalizeRad(values[3] - values[2]);
+  }
+
+  // Segments durations and slopes, missing
+  // neighbours extend the bracketing segment
+  bool hasLeft = points[0].first < points[1].first;
+  bool hasRight = points[3].first > points[2].first;
+  double duration = points[2].first - points[1].first;
+  double slope = (values[2] - values[1]) / duration;
+  double durationLeft = hasLeft ? points[1].first - points[0].first : duration;
+  double durationRight = hasRight ? points[3].first - points[2].first : duration;
+  double slopeLeft = hasLeft ? (values[1] - values[0]) / durationLeft : slope;
+  double slopeRight = hasRight ? (values[3] - values[2]) / durationRight : slope;
+
+  // Tangents at the bracketing points
+  double tangentLow;
+  double tangentUp;
+  if (kernel == CatmullRom)
+  {
+    tangentLow = hasLeft ? (values[2] - values[0]) / (points[2].first - points[0].first) : slope;
+    tangentUp = hasRight ? (values[3] - values[1]) / (points[3].first - points[1].first) : slope;
+  }
+  else if (kernel == MonotoneCubic)
+  {
+    tangentLow = monotoneTangent(slopeLeft, slope, durationLeft, duration);
+    tangentUp = monotoneTangent(slope, slopeRight, duration, durationRight);
+  }
+  else
+  {
+    throw std::logic_error("History unknown interpolation kernel");
+  }
+
+  // Cubic Hermite basis
+  double s = (timestamp - points[1].first) / duration;
+  double s2 = s * s;
+  double s3 = s2 * s;
+  double result = (2 * s3 - 3 * s2 + 1) * values[1] + (s3 - 2 * s2 + s) * duration * tangentLow +
+                  (-2 * s3 + 3 * s2) * values[2] + (s3 - s2) * duration * tangentUp;
+
+  if (valueType == AngleRad)
+  {
+    return normalizeRad(result);
+  }
+  return result;
+}
+
 void History::startLogging()
 {
+  checkNotLockFree("startLogging");
   _mutex.lock();
   _isLogging = true;
   _startLoggingTime = -1.0;
   _mutex.unlock();
 }
 
-void History::stopLogging(std::ostream& os, bool binary)
+std::unique_ptr<std::deque<History::TimedValue>> History::takeLoggedValues(double& startTime)
 {
-  _mutex.lock();
+  checkNotLockFree("stopLogging");
+  std::lock_guard<std::mutex> lock(_mutex);
   _isLogging = false;
-  if (!binary)
+  // Skip data in buffer before logging start
+  startTime = _startLoggingTime > 0.0 ? _startLoggingTime : std::numeric_limits<double>::infinity();
+  // Move the buffer out under the lock, formatting is done without it
+  std::unique_ptr<std::deque<TimedValue>> values(new std::deque<TimedValue>(takeLocked()));
+  // Only the points of the window are kept
+  if (_aggregates)
   {
-    for (const auto& it : _values)
+    _aggregates->clear();
+    for (auto it = beginLocked(); it != endLocked(); it++)
     {
-      // Skip data in buffer before logging start
-      if (_startLoggingTime > 0.0 && it.first >= _startLoggingTime)
-      {
-        // Write ascii data
-        os << std::setprecision(15) << it.first << " " << std::setprecision(15) << it.second << std::endl;
-      }
+      _aggregates->push(it->second);
     }
   }
-  else
+  if (_pyramid && sizeLocked() > 0)
   {
-    writeBinary(_values, os);
+    _pyramid->dropBefore(frontLocked().first);
   }
-  _mutex.unlock();
+  return values;
+}
+
+void History::stopLogging(std::ostream& os, bool binary)
+{
+  stopLogging(os, binary ? Binary : Ascii);
+}
+
+void History::stopLogging(std::ostream& os, LogFormat format)
+{
+  double startTime;
+  std::unique_ptr<std::deque<TimedValue>> values = takeLoggedValues(startTime);
+  HistoryLogWriter::write(*values, os, format, startTime);
+}
+
+uint64_t History::stopLogging(HistoryLogWriter& writer, std::shared_ptr<std::ostream> os, LogFormat format)
+{
+  double startTime;
+  std::unique_ptr<std::deque<TimedValue>> values = takeLoggedValues(startTime);
+  return writer.push(std::move(values), os, format, startTime);
 }
 
 void History::loadReplay(std::istream& is, bool binary, double timeShift)
 {
-  _mutex.lock();
+  checkNotLockFree("loadReplay");
+  std::lock_guard<std::mutex> lock(_mutex);
   // Clean the container
-  _values.clear();
-  // Read the number of data
+  clearValuesLocked();
+  // Read the number of data, or the magic of a compressed log
   size_t size = 0;
+  bool compressed = false;
   if (binary)
   {
-    is.read((char*)&size, sizeof(size_t));
+    char header[sizeof(size_t)] = { 0 };
+    is.read(header, sizeof(size_t));
+    if (is.gcount() != std::streamsize(sizeof(size_t)))
+    {
+      // Empty or truncated log
+      return;
+    }
+    compressed = memcmp(header, HistoryCodec::Magic, sizeof(HistoryCodec::Magic)) == 0;
+    memcpy(&size, header, sizeof(size_t));
+  }
+  else if (is.peek() == (unsigned char)HistoryCodec::Magic[0])
+  {
+    // Consume and check the magic
+    HistoryCodec::Reader magicReader(is);
+    compressed = true;
+  }
+  if (compressed)
+  {
+    // Decode block by block
+    HistoryCodec::Reader reader(is, false);
+    std::vector<TimedValue> points;
+    while (reader.nextBlock(points))
+    {
+      for (const TimedValue& point : points)
+      {
+        appendReplayValue(point.first + timeShift, point.second);
+      }
+    }
+    return;
   }
   // Read the input stream
   while (true)
@@ -208,7 +440,6 @@ void History::loadReplay(std::istream& is, bool binary, double timeShift)
     {
       if (size == 0)
       {
-        _mutex.unlock();
         return;
       }
       is.read((char*)&timestamp, sizeof(double));
@@ -223,36 +454,246 @@ void History::loadReplay(std::istream& is, bool binary, double timeShift)
       }
       if (is.peek() == '#' || is.peek() == EOF)
       {
-        _mutex.unlock();
         return;
       }
       is >> timestamp >> value;
     }
+    if (!is)
+    {
+      // Truncated log, only the complete points are kept
+      return;
+    }
     // Apply time shift
-    timestamp += timeShift;
-    // Check that timestamp is increasing
-    if (_values.size() > 0 && timestamp <= _values.back().first)
+    appendReplayValue(timestamp + timeShift, value);
+  }
+}
+
+void History::loadReplay(const std::vector<TimedValue>& values, double timeShift)
+{
+  checkNotLockFree("loadReplay");
+  std::lock_guard<std::mutex> lock(_mutex);
+  clearValuesLocked();
+  for (const TimedValue& value : values)
+  {
+    appendReplayValue(value.first + timeShift, value.second);
+  }
+}
+
+void History::loadReplayRange(std::istream& is, double tStart, double tEnd, double timeShift)
+{
+  checkNotLockFree("loadReplayRange");
+  std::lock_guard<std::mutex> lock(_mutex);
+  // Clean the container
+  clearValuesLocked();
+  // Detect the format
+  std::streamoff base = is.tellg();
+  if (base < 0)
+  {
+    throw std::runtime_error(DEBUG_INFO + " History log stream is not seekable");
+  }
+  char header[sizeof(size_t)];
+  is.read(header, sizeof(size_t));
+  if (is.gcount() != std::streamsize(sizeof(size_t)))
+  {
+    // Empty or truncated log, as loadReplay
+    return;
+  }
+  if (memcmp(header, HistoryCodec::Magic, sizeof(HistoryCodec::Magic)) == 0)
+  {
+    // Compressed logs are indexed by blocks
+    is.seekg(base);
+    for (const TimedValue& point : HistoryCodec::decodeRange(is, tStart - timeShift, tEnd - timeShift))
+    {
+      appendReplayValue(point.first + timeShift, point.second);
+    }
+    return;
+  }
+  // Binary logs have fixed size records
+  size_t size;
+  memcpy(&size, header, sizeof(size_t));
+  std::streamoff recordsStart = base + std::streamoff(sizeof(size_t));
+  const std::streamoff recordSize = 2 * sizeof(double);
+  is.seekg(0, std::ios::end);
+  std::streamoff end = is.tellg();
+  // Truncated logs are read up to their last complete record, as loadReplay
+  if (end < recordsStart)
+  {
+    return;
+  }
+  size = std::min<uint64_t>(size, uint64_t(end - recordsStart) / recordSize);
+  if (size == 0)
+  {
+    return;
+  }
+  auto timestampAt = [&is, recordsStart, recordSize, timeShift](size_t index) {
+    double timestamp;
+    is.seekg(recordsStart + std::streamoff(index) * recordSize);
+    is.read((char*)&timestamp, sizeof(double));
+    return timestamp + timeShift;
+  };
+  // Last record at or before tStart
+  size_t indexStart = 0;
+  size_t indexUp = size;
+  while (indexUp - indexStart > 1)
+  {
+    size_t indexMiddle = (indexStart + indexUp) / 2;
+    if (timestampAt(indexMiddle) <= tStart)
+    {
+      indexStart = indexMiddle;
+    }
+    else
+    {
+      indexUp = indexMiddle;
+    }
+  }
+  // First record at or after tEnd
+  size_t indexLow = indexStart;
+  size_t indexEnd = size - 1;
+  if (timestampAt(indexStart) >= tEnd)
+  {
+    indexEnd = indexStart;
+  }
+  else if (timestampAt(indexEnd) > tEnd)
+  {
+    while (indexEnd - indexLow > 1)
     {
-      _mutex.unlock();
-      throw std::runtime_error("History invalid timestamp");
+      size_t indexMiddle = (indexLow + indexEnd) / 2;
+      if (timestampAt(indexMiddle) < tEnd)
+      {
+        indexLow = indexMiddle;
+      }
+      else
+      {
+        indexEnd = indexMiddle;
+      }
     }
-    // Insert the value
-    _values.push_back(std::pair<double, double>(timestamp, value));
+  }
+  // Read the whole range at once
+  std::vector<double> records(2 * (indexEnd - indexStart + 1));
+  is.seekg(recordsStart + std::streamoff(indexStart) * recordSize);
+  is.read((char*)records.data(), records.size() * sizeof(double));
+  if (!is)
+  {
+    throw std::runtime_error(DEBUG_INFO + " failed to read binary History log");
+  }
+  for (size_t i = 0; i < records.size(); i += 2)
+  {
+    appendReplayValue(records[i] + timeShift, records[i + 1]);
+  }
+}
+
+void History::appendReplayValue(double timestamp, double value)
+{
+  // Check that timestamp is increasing
+  if (sizeLocked() > 0 && timestamp <= backLocked().first)
+  {
+    throw std::runtime_error("History invalid timestamp");
+  }
+  // Insert the value
+  pushLocked(timestamp, value, false);
+  if (_pyramid)
+  {
+    _pyramid->push(timestamp, value);
+  }
+  if (_aggregates)
+  {
+    _aggregates->push(value);
+  }
+}
+
+void History::enablePyramid(size_t factor, size_t nbLevels)
+{
+  checkNotLockFree("enablePyramid");
+  std::unique_ptr<HistoryPyramid> pyramid(new HistoryPyramid(factor, nbLevels));
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto it = beginLocked(); it != endLocked(); it++)
+  {
+    pyramid->push(it->first, it->second);
+  }
+  _pyramid = std::move(pyramid);
+}
+
+void History::enableAggregates()
+{
+  checkNotLockFree("enableAggregates");
+  std::unique_ptr<HistoryAggregates> aggregates(new HistoryAggregates());
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto it = beginLocked(); it != endLocked(); it++)
+  {
+    aggregates->push(it->second);
+  }
+  _aggregates = std::move(aggregates);
+}
+
+HistoryAggregates::Summary History::getAggregates() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_aggregates)
+  {
+    throw std::logic_error(DEBUG_INFO + " History aggregates are not enabled");
+  }
+  return _aggregates->summary();
+}
+
+std::vector<HistoryPyramid::Bucket> History::query(double tStart, double tEnd, size_t maxPoints) const
+{
+  checkNotLockFree("query");
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto first = std::lower_bound(beginLocked(), endLocked(), tStart,
+                                [](const TimedValue& point, double t) { return point.first < t; });
+  auto last = std::upper_bound(first, endLocked(), tEnd,
+                               [](double t, const TimedValue& point) { return t < point.first; });
+  if (_pyramid && size_t(last - first) > maxPoints)
+  {
+    return _pyramid->query(tStart, tEnd, maxPoints);
+  }
+  // Raw values as single point buckets
+  std::vector<HistoryPyramid::Bucket> buckets;
+  buckets.reserve(last - first);
+  for (auto it = first; it != last; it++)
+  {
+    buckets.push_back(HistoryPyramid::Bucket{ it->first, it->first, it->second, it->second, it->second, 1 });
+  }
+  return buckets;
+}
+
+void History::clearValuesLocked()
+{
+  clearLocked();
+  if (_pyramid)
+  {
+    _pyramid->clear();
+  }
+  if (_aggregates)
+  {
+    _aggregates->clear();
   }
 }
 
 std::deque<History::TimedValue> History::getValues()
 {
-  return _values;
+  if (_ring)
+  {
+    return _ring->snapshot();
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  return std::deque<TimedValue>(beginLocked(), endLocked());
 }
 
 void History::clear()
 {
-  _values.clear();
+  if (_ring)
+  {
+    _ring->clear();
+    return;
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  clearValuesLocked();
 }
 
 void History::startNamedLog(const std::string& sessionName)
 {
+  checkNotLockFree("startNamedLog");
   _mutex.lock();
   if (_activeLogs.count(sessionName) > 0)
   {
@@ -281,7 +722,7 @@ void History::freezeNamedLog(const std::string& sessionName)
   _mutex.unlock();
 }
 
-void History::closeFrozenLog(const std::string& sessionName, std::ostream& os)
+std::unique_ptr<std::deque<History::TimedValue>> History::takeFrozenLog(const std::string& sessionName)
 {
   _mutex.lock();
   if (_frozenLogs.count(sessionName) == 0)
@@ -292,21 +733,24 @@ void History::closeFrozenLog(const std::string& sessionName, std::ostream& os)
   std::unique_ptr<std::deque<TimedValue>> values = std::move(_frozenLogs[sessionName]);
   _frozenLogs.erase(sessionName);
   _mutex.unlock();
+  return values;
+}
 
-  writeBinary(*values, os);
+void History::closeFrozenLog(const std::string& sessionName, std::ostream& os, LogFormat format)
+{
+  std::unique_ptr<std::deque<TimedValue>> values = takeFrozenLog(sessionName);
+  HistoryLogWriter::write(*values, os, format);
+}
+
+uint64_t History::closeFrozenLog(const std::string& sessionName, HistoryLogWriter& writer,
+                                 std::shared_ptr<std::ostream> os, LogFormat format)
+{
+  return writer.push(takeFrozenLog(sessionName), os, format);
 }
 
 void History::writeBinary(const std::deque<History::TimedValue>& values, std::ostream& os)
 {
-  // When writing in binary, use all values
-  size_t size = values.size();
-  os.write((const char*)&size, sizeof(size_t));
-  for (const auto& it : values)
-  {
-    // Write binary data
-    os.write((const char*)&(it.first), sizeof(double));
-    os.write((const char*)&(it.second), sizeof(double));
-  }
+  HistoryLogWriter::write(values, os, Binary);
 }
 
 }  // namespace starkit_utils
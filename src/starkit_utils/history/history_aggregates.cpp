@@ -0,0 +1,80 @@
+#include "starkit_utils/history/history_aggregates.h"
+
+namespace starkit_utils
+{
+HistoryAggregates::HistoryAggregates() : _nbPushed(0), _nbPopped(0), _mean(0.0), _m2(0.0)
+{
+}
+
+void HistoryAggregates::push(double value)
+{
+  while (!_minQueue.empty() && _minQueue.back().second >= value)
+  {
+    _minQueue.pop_back();
+  }
+  _minQueue.push_back(std::make_pair(_nbPushed, value));
+  while (!_maxQueue.empty() && _maxQueue.back().second <= value)
+  {
+    _maxQueue.pop_back();
+  }
+  _maxQueue.push_back(std::make_pair(_nbPushed, value));
+  _nbPushed++;
+
+  double delta = value - _mean;
+  _mean += delta / (_nbPushed - _nbPopped);
+  _m2 += delta * (value - _mean);
+}
+
+void HistoryAggregates::pop(double value)
+{
+  if (!_minQueue.empty() && _minQueue.front().first == _nbPopped)
+  {
+    _minQueue.pop_front();
+  }
+  if (!_maxQueue.empty() && _maxQueue.front().first == _nbPopped)
+  {
+    _maxQueue.pop_front();
+  }
+  _nbPopped++;
+
+  uint64_t count = _nbPushed - _nbPopped;
+  if (count == 0)
+  {
+    // Start again from exact sums
+    _mean = 0.0;
+    _m2 = 0.0;
+    return;
+  }
+  double delta = value - _mean;
+  _mean -= delta / count;
+  _m2 -= delta * (value - _mean);
+  // Rounding errors may not cancel exactly
+  if (_m2 < 0.0)
+  {
+    _m2 = 0.0;
+  }
+}
+
+void HistoryAggregates::clear()
+{
+  _nbPopped = _nbPushed;
+  _minQueue.clear();
+  _maxQueue.clear();
+  _mean = 0.0;
+  _m2 = 0.0;
+}
+
+HistoryAggregates::Summary HistoryAggregates::summary() const
+{
+  Summary summary{ size_t(_nbPushed - _nbPopped), 0.0, 0.0, 0.0, 0.0 };
+  if (summary.count > 0)
+  {
+    summary.min = _minQueue.front().second;
+    summary.max = _maxQueue.front().second;
+    summary.mean = _mean;
+    summary.variance = _m2 / summary.count;
+  }
+  return summary;
+}
+
+}  // namespace starkit_utils
@@ -0,0 +1,488 @@
+#include "starkit_utils/history/history_codec.h"
+#include "starkit_utils/threading/multi_core.h"
+#include "starkit_utils/util.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace starkit_utils
+{
+const char HistoryCodec::Magic[8] = { '\x89', 'S', 'K', 'H', 'G', 'O', 'R', '1' };
+const char HistoryCodec::IndexMagic[8] = { '\x89', 'S', 'K', 'H', 'I', 'D', 'X', '1' };
+const size_t HistoryCodec::DefaultBlockSize = 1024;
+const size_t HistoryCodec::BlockHeaderSize = 2 * sizeof(uint32_t) + 2 * sizeof(double);
+
+/**
+ * Most significant bit first bit stream writer
+ */
+class BitWriter
+{
+public:
+  BitWriter() : _buffer(0), _nbBits(0)
+  {
+  }
+
+  void write(uint64_t value, int nbBits)
+  {
+    // Fill the pending byte with as many bits as possible at once
+    while (nbBits > 0)
+    {
+      int nbTaken = std::min(8 - _nbBits, nbBits);
+      uint64_t bits = (value >> (nbBits - nbTaken)) & ((1u << nbTaken) - 1);
+      _buffer = (_buffer << nbTaken) | bits;
+      _nbBits += nbTaken;
+      nbBits -= nbTaken;
+      if (_nbBits == 8)
+      {
+        _bytes.push_back((char)_buffer);
+        _buffer = 0;
+        _nbBits = 0;
+      }
+    }
+  }
+
+  std::string& bytes()
+  {
+    if (_nbBits > 0)
+    {
+      _bytes.push_back((char)(_buffer << (8 - _nbBits)));
+      _buffer = 0;
+      _nbBits = 0;
+    }
+    return _bytes;
+  }
+
+private:
+  std::string _bytes;
+  uint8_t _buffer;
+  int _nbBits;
+};
+
+/**
+ * Most significant bit first bit stream reader
+ */
+class BitReader
+{
+public:
+  BitReader(const std::string& bytes) : _bytes(bytes), _position(0)
+  {
+  }
+
+  uint64_t read(int nbBits)
+  {
+    if (_position + nbBits > 8 * _bytes.size())
+    {
+      throw std::runtime_error(DEBUG_INFO + " truncated History block");
+    }
+    uint64_t value = 0;
+    // Consume the remaining bits of the current byte at once
+    while (nbBits > 0)
+    {
+      int nbAvailable = 8 - _position % 8;
+      int nbTaken = std::min(nbAvailable, nbBits);
+      uint8_t byte = _bytes[_position / 8];
+      uint64_t bits = (byte >> (nbAvailable - nbTaken)) & ((1u << nbTaken) - 1);
+      value = (value << nbTaken) | bits;
+      _position += nbTaken;
+      nbBits -= nbTaken;
+    }
+    return value;
+  }
+
+private:
+  const std::string& _bytes;
+  size_t _position;
+};
+
+static uint64_t toBits(double value)
+{
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(double));
+  return bits;
+}
+
+static double fromBits(uint64_t bits)
+{
+  double value;
+  memcpy(&value, &bits, sizeof(double));
+  return value;
+}
+
+/**
+ * Delta-of-delta buckets: prefix, prefix length and payload length
+ */
+struct DodBucket
+{
+  uint64_t prefix;
+  int prefixBits;
+  int valueBits;
+};
+static const DodBucket dodBuckets[] = { { 0x2, 2, 7 }, { 0x6, 3, 9 }, { 0xe, 4, 12 } };
+
+static void writeDod(BitWriter& writer, int64_t dod)
+{
+  if (dod == 0)
+  {
+    writer.write(0, 1);
+    return;
+  }
+  for (const DodBucket& bucket : dodBuckets)
+  {
+    int64_t offset = (int64_t(1) << (bucket.valueBits - 1)) - 1;
+    if (dod >= -offset && dod <= offset + 1)
+    {
+      writer.write(bucket.prefix, bucket.prefixBits);
+      writer.write(uint64_t(dod + offset), bucket.valueBits);
+      return;
+    }
+  }
+  writer.write(0xf, 4);
+  writer.write(uint64_t(dod), 64);
+}
+
+static int64_t readDod(BitReader& reader)
+{
+  if (reader.read(1) == 0)
+  {
+    return 0;
+  }
+  for (const DodBucket& bucket : dodBuckets)
+  {
+    if (reader.read(1) == 0)
+    {
+      int64_t offset = (int64_t(1) << (bucket.valueBits - 1)) - 1;
+      return int64_t(reader.read(bucket.valueBits)) - offset;
+    }
+  }
+  return int64_t(reader.read(64));
+}
+
+std::string HistoryCodec::encodeBlock(const TimedValue* points, size_t nbPoints)
+{
+  BitWriter writer;
+  if (nbPoints == 0)
+  {
+    return writer.bytes();
+  }
+  uint64_t prevTimestamp = toBits(points[0].first);
+  uint64_t prevValue = toBits(points[0].second);
+  writer.write(prevTimestamp, 64);
+  writer.write(prevValue, 64);
+  uint64_t prevDelta = 0;
+  int prevLeading = -1;
+  int prevTrailing = 0;
+  for (size_t i = 1; i < nbPoints; i++)
+  {
+    // Timestamp: delta-of-delta of the bit patterns
+    uint64_t timestamp = toBits(points[i].first);
+    uint64_t delta = timestamp - prevTimestamp;
+    writeDod(writer, int64_t(delta - prevDelta));
+    prevDelta = delta;
+    prevTimestamp = timestamp;
+    // Value: XOR with the previous one
+    uint64_t value = toBits(points[i].second);
+    uint64_t xorValue = value ^ prevValue;
+    prevValue = value;
+    if (xorValue == 0)
+    {
+      writer.write(0, 1);
+      continue;
+    }
+    writer.write(1, 1);
+    int leading = __builtin_clzll(xorValue);
+    int trailing = __builtin_ctzll(xorValue);
+    if (prevLeading >= 0 && leading >= prevLeading && trailing >= prevTrailing)
+    {
+      // Meaningful bits fit in the previous window
+      writer.write(0, 1);
+      writer.write(xorValue >> prevTrailing, 64 - prevLeading - prevTrailing);
+    }
+    else
+    {
+      int length = 64 - leading - trailing;
+      writer.write(1, 1);
+      writer.write(leading, 6);
+      writer.write(length - 1, 6);
+      writer.write(xorValue >> trailing, length);
+      prevLeading = leading;
+      prevTrailing = trailing;
+    }
+  }
+  return writer.bytes();
+}
+
+void HistoryCodec::decodeBlock(const std::string& bytes, size_t nbPoints, std::vector<TimedValue>& points)
+{
+  if (nbPoints == 0)
+  {
+    return;
+  }
+  BitReader reader(bytes);
+  uint64_t timestamp = reader.read(64);
+  uint64_t value = reader.read(64);
+  points.push_back(TimedValue(fromBits(timestamp), fromBits(value)));
+  uint64_t delta = 0;
+  int leading = 0;
+  int trailing = 0;
+  for (size_t i = 1; i < nbPoints; i++)
+  {
+    delta += uint64_t(readDod(reader));
+    timestamp += delta;
+    if (reader.read(1) == 1)
+    {
+      if (reader.read(1) == 1)
+      {
+        leading = reader.read(6);
+        int length = reader.read(6) + 1;
+        trailing = 64 - leading - length;
+      }
+      value ^= reader.read(64 - leading - trailing) << trailing;
+    }
+    points.push_back(TimedValue(fromBits(timestamp), fromBits(value)));
+  }
+}
+
+void HistoryCodec::writeBlockHeader(const BlockHeader& header, std::ostream& os)
+{
+  os.write((const char*)&header.nbPoints, sizeof(uint32_t));
+  os.write((const char*)&header.nbBytes, sizeof(uint32_t));
+  os.write((const char*)&header.firstTimestamp, sizeof(double));
+  os.write((const char*)&header.lastTimestamp, sizeof(double));
+}
+
+HistoryCodec::BlockHeader HistoryCodec::readBlockHeader(std::istream& is)
+{
+  BlockHeader header;
+  is.read((char*)&header.nbPoints, sizeof(uint32_t));
+  is.read((char*)&header.nbBytes, sizeof(uint32_t));
+  is.read((char*)&header.firstTimestamp, sizeof(double));
+  is.read((char*)&header.lastTimestamp, sizeof(double));
+  if (!is)
+  {
+    throw std::runtime_error(DEBUG_INFO + " truncated compressed History log");
+  }
+  return header;
+}
+
+void HistoryCodec::encode(const std::deque<TimedValue>& values, std::ostream& os, size_t blockSize)
+{
+  if (blockSize == 0)
+  {
+    throw std::logic_error(DEBUG_INFO + " block size must be positive");
+  }
+  os.write(Magic, sizeof(Magic));
+  uint64_t offset = sizeof(Magic);
+  std::vector<IndexEntry> index;
+  std::vector<TimedValue> points;
+  points.reserve(blockSize);
+  for (size_t start = 0; start < values.size(); start += blockSize)
+  {
+    points.assign(values.begin() + start, values.begin() + std::min(start + blockSize, values.size()));
+    std::string bytes = encodeBlock(points.data(), points.size());
+    BlockHeader header = { uint32_t(points.size()), uint32_t(bytes.size()), points.front().first,
+                           points.back().first };
+    writeBlockHeader(header, os);
+    os.write(bytes.data(), bytes.size());
+    index.push_back(IndexEntry{ header.firstTimestamp, header.lastTimestamp, offset });
+    offset += BlockHeaderSize + bytes.size();
+  }
+  BlockHeader end = { 0, 0, 0.0, 0.0 };
+  writeBlockHeader(end, os);
+  offset += BlockHeaderSize;
+  // Index and trailer
+  uint64_t nbBlocks = index.size();
+  os.write((const char*)&nbBlocks, sizeof(uint64_t));
+  for (const IndexEntry& entry : index)
+  {
+    os.write((const char*)&entry.firstTimestamp, sizeof(double));
+    os.write((const char*)&entry.lastTimestamp, sizeof(double));
+    os.write((const char*)&entry.offset, sizeof(uint64_t));
+  }
+  os.write((const char*)&offset, sizeof(uint64_t));
+  os.write(IndexMagic, sizeof(IndexMagic));
+}
+
+std::vector<HistoryCodec::IndexEntry> HistoryCodec::readIndex(std::istream& is)
+{
+  std::streamoff base = is.tellg();
+  Reader reader(is);
+  std::vector<IndexEntry> index;
+  // Look for the trailer at the end of the stream
+  is.seekg(0, std::ios::end);
+  std::streamoff end = is.tellg();
+  if (base < 0 || end < 0)
+  {
+    throw std::runtime_error(DEBUG_INFO + " compressed History log stream is not seekable");
+  }
+  if (end - base >= std::streamoff(sizeof(Magic) + BlockHeaderSize + 2 * sizeof(uint64_t) + sizeof(IndexMagic)))
+  {
+    uint64_t indexOffset;
+    char magic[sizeof(IndexMagic)];
+    is.seekg(end - sizeof(uint64_t) - sizeof(IndexMagic));
+    is.read((char*)&indexOffset, sizeof(uint64_t));
+    is.read(magic, sizeof(IndexMagic));
+    if (is && memcmp(magic, IndexMagic, sizeof(IndexMagic)) == 0)
+    {
+      uint64_t nbBlocks;
+      is.seekg(base + std::streamoff(indexOffset));
+      is.read((char*)&nbBlocks, sizeof(uint64_t));
+      if (!is || nbBlocks > uint64_t(end - base) / BlockHeaderSize)
+      {
+        throw std::runtime_error(DEBUG_INFO + " invalid compressed History log index");
+      }
+      index.resize(nbBlocks);
+      for (IndexEntry& entry : index)
+      {
+        is.read((char*)&entry.firstTimestamp, sizeof(double));
+        is.read((char*)&entry.lastTimestamp, sizeof(double));
+        is.read((char*)&entry.offset, sizeof(uint64_t));
+      }
+      if (!is)
+      {
+        throw std::runtime_error(DEBUG_INFO + " truncated compressed History log index");
+      }
+      return index;
+    }
+    is.clear();
+  }
+  // No index: hop from block header to block header
+  uint64_t offset = sizeof(Magic);
+  is.seekg(base + std::streamoff(offset));
+  while (true)
+  {
+    BlockHeader header = readBlockHeader(is);
+    if (header.nbPoints == 0)
+    {
+      return index;
+    }
+    index.push_back(IndexEntry{ header.firstTimestamp, header.lastTimestamp, offset });
+    offset += BlockHeaderSize + header.nbBytes;
+    is.seekg(base + std::streamoff(offset));
+  }
+}
+
+std::vector<HistoryCodec::TimedValue> HistoryCodec::decodeRange(std::istream& is, double tStart, double tEnd)
+{
+  std::streamoff base = is.tellg();
+  std::vector<IndexEntry> index = readIndex(is);
+  std::vector<TimedValue> points;
+  if (index.empty())
+  {
+    return points;
+  }
+  // Blocks from the last one starting before tStart to the
+  // first one starting after tEnd
+  auto byFirst = [](double t, const IndexEntry& entry) { return t < entry.firstTimestamp; };
+  size_t blockStart = std::upper_bound(index.begin(), index.end(), tStart, byFirst) - index.begin();
+  blockStart = blockStart > 0 ? blockStart - 1 : 0;
+  size_t blockEnd = std::upper_bound(index.begin(), index.end(), tEnd, byFirst) - index.begin();
+  blockEnd = std::min(blockEnd, index.size() - 1);
+  is.clear();
+  is.seekg(base + std::streamoff(index[blockStart].offset));
+  for (size_t block = blockStart; block <= blockEnd; block++)
+  {
+    BlockHeader header = readBlockHeader(is);
+    std::string bytes(header.nbBytes, '\0');
+    is.read(&bytes[0], header.nbBytes);
+    if (!is || header.nbPoints == 0)
+    {
+      throw std::runtime_error(DEBUG_INFO + " truncated compressed History log");
+    }
+    decodeBlock(bytes, header.nbPoints, points);
+  }
+  // Keep the range and its surrounding points
+  auto byTimestamp = [](double t, const TimedValue& point) { return t < point.first; };
+  size_t start = std::upper_bound(points.begin(), points.end(), tStart, byTimestamp) - points.begin();
+  start = start > 0 ? start - 1 : 0;
+  auto lowerByTimestamp = [](const TimedValue& point, double t) { return point.first < t; };
+  size_t end = std::lower_bound(points.begin(), points.end(), tEnd, lowerByTimestamp) - points.begin();
+  end = std::min(end, points.size() - 1);
+  if (end < start)
+  {
+    end = start;
+  }
+  return std::vector<TimedValue>(points.begin() + start, points.begin() + end + 1);
+}
+
+std::vector<HistoryCodec::TimedValue> HistoryCodec::decode(std::istream& is, int nbThreads)
+{
+  // Read all encoded blocks
+  Reader reader(is);
+  std::vector<BlockHeader> headers;
+  std::vector<std::string> blocks;
+  BlockHeader header;
+  std::string bytes;
+  while (reader.nextEncodedBlock(header, bytes))
+  {
+    headers.push_back(header);
+    blocks.push_back(std::move(bytes));
+  }
+  // Decode them independently
+  std::vector<std::vector<TimedValue>> decoded(blocks.size());
+  if (blocks.size() > 0)
+  {
+    MultiCore::runParallelTask(
+        [&headers, &blocks, &decoded](int start, int end) {
+          for (int block = start; block < end; block++)
+          {
+            decodeBlock(blocks[block], headers[block].nbPoints, decoded[block]);
+          }
+        },
+        blocks.size(), std::max(1, nbThreads));
+  }
+  std::vector<TimedValue> values;
+  for (const auto& points : decoded)
+  {
+    values.insert(values.end(), points.begin(), points.end());
+  }
+  return values;
+}
+
+HistoryCodec::Reader::Reader(std::istream& is, bool readMagic) : _is(is), _ended(false)
+{
+  if (readMagic)
+  {
+    char magic[sizeof(Magic)];
+    is.read(magic, sizeof(Magic));
+    if (!is || memcmp(magic, Magic, sizeof(Magic)) != 0)
+    {
+      throw std::runtime_error(DEBUG_INFO + " not a compressed History log");
+    }
+  }
+}
+
+bool HistoryCodec::Reader::nextEncodedBlock(BlockHeader& header, std::string& bytes)
+{
+  if (_ended)
+  {
+    return false;
+  }
+  header = readBlockHeader(_is);
+  if (header.nbPoints == 0)
+  {
+    _ended = true;
+    return false;
+  }
+  bytes.resize(header.nbBytes);
+  _is.read(&bytes[0], header.nbBytes);
+  if (!_is)
+  {
+    throw std::runtime_error(DEBUG_INFO + " truncated compressed History log");
+  }
+  return true;
+}
+
+bool HistoryCodec::Reader::nextBlock(std::vector<TimedValue>& points)
+{
+  BlockHeader header;
+  std::string bytes;
+  points.clear();
+  if (!nextEncodedBlock(header, bytes))
+  {
+    return false;
+  }
+  decodeBlock(bytes, header.nbPoints, points);
+  return true;
+}
+
+}  // namespace starkit_utils
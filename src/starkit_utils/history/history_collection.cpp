@@ -0,0 +1,295 @@
+#include "starkit_utils/history/history_collection.h"
+#include "starkit_utils/util.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace starkit_utils
+{
+HistoryCollection::HistoryCollection(double window) : _mutex(), _windowSize(window), _head(0), _size(0)
+{
+}
+
+void HistoryCollection::setWindowSize(double window)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _windowSize = window;
+}
+
+size_t HistoryCollection::addChannel(const std::string& name, History::ValueType valueType)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_indices.count(name) > 0)
+  {
+    throw std::logic_error(DEBUG_INFO + " there is already a channel with name '" + name + "'");
+  }
+  if (_size > 0)
+  {
+    throw std::logic_error(DEBUG_INFO + " cannot add channel '" + name + "' once values have been pushed");
+  }
+  if (valueType != History::Number && valueType != History::AngleRad)
+  {
+    throw std::logic_error("HistoryCollection unknown value type for channel '" + name + "'");
+  }
+  size_t index = _names.size();
+  _names.push_back(name);
+  _types.push_back(valueType);
+  // The row size changes, cleared rows are dropped
+  _timestamps.clear();
+  _values.clear();
+  _head = 0;
+  _indices[name] = index;
+  if (valueType == History::AngleRad)
+  {
+    _angleChannels.push_back(index);
+  }
+  return index;
+}
+
+size_t HistoryCollection::nbChannels() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _names.size();
+}
+
+size_t HistoryCollection::getChannelIndex(const std::string& name) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _indices.find(name);
+  if (it == _indices.end())
+  {
+    throw std::out_of_range(DEBUG_INFO + " there is no channel with name '" + name + "'");
+  }
+  return it->second;
+}
+
+std::string HistoryCollection::getChannelName(size_t channel) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _names.at(channel);
+}
+
+size_t HistoryCollection::size() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _size;
+}
+
+double HistoryCollection::frontTimestamp() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _size > 0 ? _timestamps[_head] : 0.0;
+}
+
+double HistoryCollection::backTimestamp() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _size > 0 ? _timestamps[rowIndex(_size - 1)] : 0.0;
+}
+
+void HistoryCollection::pushValues(double timestamp, const std::vector<double>& values)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  // Checked under the lock, so that no channel is added meanwhile
+  if (values.size() != _names.size())
+  {
+    throw std::logic_error(DEBUG_INFO + " expecting " + std::to_string(_names.size()) + " values, got " +
+                           std::to_string(values.size()));
+  }
+  pushValuesLocked(timestamp, values.data());
+}
+
+void HistoryCollection::pushValues(double timestamp, const double* values)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  pushValuesLocked(timestamp, values);
+}
+
+void HistoryCollection::pushValuesLocked(double timestamp, const double* values)
+{
+  size_t nbChannels = _names.size();
+  // Check that timestamp is increasing
+  if (_size > 0)
+  {
+    double lastTimestamp = _timestamps[rowIndex(_size - 1)];
+    if (timestamp < lastTimestamp)
+    {
+      throw std::logic_error("HistoryCollection invalid timestamp");
+    }
+    if (timestamp == lastTimestamp)
+    {
+      return;
+    }
+  }
+  // Shrink the window, the new row is always kept
+  while (_size > 0 && timestamp - _timestamps[_head] > _windowSize)
+  {
+    _head = rowIndex(1);
+    _size--;
+  }
+  // Insert the row
+  if (_size == _timestamps.size())
+  {
+    grow();
+  }
+  size_t index = rowIndex(_size);
+  _timestamps[index] = timestamp;
+  std::copy(values, values + nbChannels, _values.begin() + index * nbChannels);
+  _size++;
+}
+
+size_t HistoryCollection::rowIndex(size_t row) const
+{
+  size_t index = _head + row;
+  return index >= _timestamps.size() ? index - _timestamps.size() : index;
+}
+
+void HistoryCollection::grow()
+{
+  size_t nbChannels = _names.size();
+  size_t capacity = std::max<size_t>(16, 2 * _timestamps.size());
+  std::vector<double> timestamps(capacity);
+  std::vector<double> values(capacity * nbChannels);
+  for (size_t row = 0; row < _size; row++)
+  {
+    size_t index = rowIndex(row);
+    timestamps[row] = _timestamps[index];
+    std::copy(_values.begin() + index * nbChannels, _values.begin() + (index + 1) * nbChannels,
+              values.begin() + row * nbChannels);
+  }
+  _timestamps.swap(timestamps);
+  _values.swap(values);
+  _head = 0;
+}
+
+void HistoryCollection::bracket(double timestamp, size_t& rowLow, size_t& rowUp, double& wUp) const
+{
+  wUp = 0.0;
+  if (_size == 1 || timestamp <= _timestamps[_head])
+  {
+    rowLow = rowUp = 0;
+    return;
+  }
+  if (timestamp >= _timestamps[rowIndex(_size - 1)])
+  {
+    rowLow = rowUp = _size - 1;
+    return;
+  }
+  // Bijection search
+  rowLow = 0;
+  rowUp = _size - 1;
+  while (rowUp - rowLow > 1)
+  {
+    size_t rowMiddle = (rowLow + rowUp) / 2;
+    if (_timestamps[rowIndex(rowMiddle)] <= timestamp)
+    {
+      rowLow = rowMiddle;
+    }
+    else
+    {
+      rowUp = rowMiddle;
+    }
+  }
+  double tsLow = _timestamps[rowIndex(rowLow)];
+  wUp = (timestamp - tsLow) / (_timestamps[rowIndex(rowUp)] - tsLow);
+}
+
+void HistoryCollection::blendRows(const double* low, const double* up, double wUp, double* out) const
+{
+  size_t nbChannels = _names.size();
+  double wLow = 1.0 - wUp;
+  // Linear blend of all channels, contiguous and branch free so that
+  // the compiler can vectorize it
+  for (size_t channel = 0; channel < nbChannels; channel++)
+  {
+    out[channel] = wLow * low[channel] + wUp * up[channel];
+  }
+  // Angular channels are blended on the unit circle, as History does
+  for (size_t channel : _angleChannels)
+  {
+    double x = wLow * std::cos(low[channel]) + wUp * std::cos(up[channel]);
+    double y = wLow * std::sin(low[channel]) + wUp * std::sin(up[channel]);
+    out[channel] = std::atan2(y, x);
+  }
+}
+
+void HistoryCollection::interpolateAll(double timestamp, std::vector<double>& out) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  // Resized under the lock, so that no channel is added meanwhile
+  out.resize(_names.size());
+  interpolateAllLocked(timestamp, out.data());
+}
+
+void HistoryCollection::interpolateAll(double timestamp, double* out) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  interpolateAllLocked(timestamp, out);
+}
+
+void HistoryCollection::interpolateAllLocked(double timestamp, double* out) const
+{
+  size_t nbChannels = _names.size();
+  if (_size == 0)
+  {
+    for (size_t channel = 0; channel < nbChannels; channel++)
+    {
+      out[channel] = 0.0;
+    }
+    return;
+  }
+  size_t rowLow, rowUp;
+  double wUp;
+  bracket(timestamp, rowLow, rowUp, wUp);
+  const double* low = _values.data() + rowIndex(rowLow) * nbChannels;
+  const double* up = _values.data() + rowIndex(rowUp) * nbChannels;
+  if (rowLow == rowUp)
+  {
+    for (size_t channel = 0; channel < nbChannels; channel++)
+    {
+      out[channel] = low[channel];
+    }
+    return;
+  }
+  blendRows(low, up, wUp, out);
+}
+
+double HistoryCollection::interpolate(size_t channel, double timestamp) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  size_t nbChannels = _names.size();
+  if (channel >= nbChannels)
+  {
+    throw std::out_of_range(DEBUG_INFO + " invalid channel " + std::to_string(channel));
+  }
+  if (_size == 0)
+  {
+    return 0.0;
+  }
+  size_t rowLow, rowUp;
+  double wUp;
+  bracket(timestamp, rowLow, rowUp, wUp);
+  double low = _values[rowIndex(rowLow) * nbChannels + channel];
+  double up = _values[rowIndex(rowUp) * nbChannels + channel];
+  if (rowLow == rowUp)
+  {
+    return low;
+  }
+  double wLow = 1.0 - wUp;
+  if (_types[channel] == History::AngleRad)
+  {
+    return std::atan2(wLow * std::sin(low) + wUp * std::sin(up), wLow * std::cos(low) + wUp * std::cos(up));
+  }
+  return wLow * low + wUp * up;
+}
+
+void HistoryCollection::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _timestamps.clear();
+  _values.clear();
+  _head = 0;
+  _size = 0;
+}
+
+}  // namespace starkit_utils
@@ -0,0 +1,203 @@
+#include "starkit_utils/history/history_loader.h"
+#include "starkit_utils/history/history_codec.h"
+#include "starkit_utils/util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <sys/stat.h>
+#include <thread>
+
+namespace starkit_utils
+{
+/**
+ * Size of the chunks read from the logs
+ */
+static const size_t chunkSize = 1 << 20;
+
+static bool isBlank(char c)
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/**
+ * Parse a double at p, throws a runtime_error on failure
+ */
+static const char* parseDouble(const char* p, const char* end, double& value)
+{
+  while (p < end && (*p == ' ' || *p == '\t'))
+  {
+    p++;
+  }
+  std::from_chars_result result = std::from_chars(p, end, value);
+  if (result.ec != std::errc())
+  {
+    throw std::runtime_error(DEBUG_INFO + " invalid ascii History log line: '" + std::string(p, end) + "'");
+  }
+  return result.ptr;
+}
+
+std::vector<History::TimedValue> HistoryLoader::parseAscii(std::istream& is)
+{
+  std::vector<History::TimedValue> values;
+  std::vector<char> buffer(chunkSize);
+  // Bytes not parsed yet are [begin, end[
+  size_t begin = 0;
+  size_t end = 0;
+  bool eof = false;
+  while (true)
+  {
+    while (begin < end && isBlank(buffer[begin]))
+    {
+      begin++;
+    }
+    // Make sure a whole line is available
+    const char* data = buffer.data();
+    const char* lineEnd = static_cast<const char*>(memchr(data + begin, '\n', end - begin));
+    if (lineEnd == nullptr && !eof)
+    {
+      // Move the partial line at the beginning and read the next chunk
+      memmove(buffer.data(), buffer.data() + begin, end - begin);
+      end -= begin;
+      begin = 0;
+      if (end == buffer.size())
+      {
+        buffer.resize(2 * buffer.size());
+      }
+      is.read(buffer.data() + end, buffer.size() - end);
+      end += is.gcount();
+      eof = !is;
+      continue;
+    }
+    if (begin == end || buffer[begin] == '#')
+    {
+      return values;
+    }
+    if (lineEnd == nullptr)
+    {
+      lineEnd = data + end;
+    }
+    History::TimedValue value;
+    const char* p = parseDouble(data + begin, lineEnd, value.first);
+    p = parseDouble(p, lineEnd, value.second);
+    values.push_back(value);
+    begin = p - data;
+  }
+}
+
+/**
+ * Load the log at given path into history
+ */
+static void loadFile(const std::string& path, History& history, bool binary, double timeShift)
+{
+  std::vector<char> streamBuffer(chunkSize);
+  std::ifstream file;
+  file.rdbuf()->pubsetbuf(streamBuffer.data(), streamBuffer.size());
+  file.open(path, std::ios::binary);
+  if (!file)
+  {
+    throw std::runtime_error(DEBUG_INFO + " failed to open '" + path + "': " + strerror(errno));
+  }
+  if (!binary && file.peek() != (unsigned char)HistoryCodec::Magic[0])
+  {
+    history.loadReplay(HistoryLoader::parseAscii(file), timeShift);
+  }
+  else
+  {
+    history.loadReplay(file, binary, timeShift);
+  }
+}
+
+HistoryLoader::Histories HistoryLoader::loadReplayDirectory(const std::string& directory, bool binary,
+                                                            double timeShift, int nbThreads,
+                                                            const std::string& extension)
+{
+  // List the logs
+  DIR* dir = opendir(directory.c_str());
+  if (dir == nullptr)
+  {
+    throw std::runtime_error(DEBUG_INFO + " failed to open directory '" + directory + "': " + strerror(errno));
+  }
+  std::vector<std::string> fileNames;
+  while (struct dirent* entry = readdir(dir))
+  {
+    std::string fileName = entry->d_name;
+    if (fileName[0] == '.' || fileName.size() < extension.size() ||
+        fileName.compare(fileName.size() - extension.size(), extension.size(), extension) != 0)
+    {
+      continue;
+    }
+    struct stat fileStat;
+    if (stat((directory + "/" + fileName).c_str(), &fileStat) == 0 && S_ISREG(fileStat.st_mode))
+    {
+      fileNames.push_back(fileName);
+    }
+  }
+  closedir(dir);
+  std::sort(fileNames.begin(), fileNames.end());
+
+  // Create the histories
+  Histories histories;
+  std::vector<History*> targets;
+  for (const std::string& fileName : fileNames)
+  {
+    std::string name = fileName.substr(0, fileName.find_last_of('.'));
+    if (name == "")
+    {
+      name = fileName;
+    }
+    if (histories.count(name) > 0)
+    {
+      throw std::runtime_error(DEBUG_INFO + " several logs named '" + name + "' in '" + directory + "'");
+    }
+    histories[name] = std::unique_ptr<History>(new History());
+    targets.push_back(histories[name].get());
+  }
+
+  // Workers take the next file to load until all are done, so that
+  // big logs do not delay the small ones
+  if (nbThreads <= 0)
+  {
+    nbThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  nbThreads = std::min(nbThreads, (int)fileNames.size());
+  std::atomic<size_t> next(0);
+  std::vector<std::string> errors(fileNames.size());
+  auto worker = [&]() {
+    for (size_t index = next++; index < fileNames.size(); index = next++)
+    {
+      try
+      {
+        loadFile(directory + "/" + fileNames[index], *targets[index], binary, timeShift);
+      }
+      catch (const std::exception& e)
+      {
+        errors[index] = e.what();
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 1; i < nbThreads; i++)
+  {
+    threads.push_back(std::thread(worker));
+  }
+  worker();
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+  for (size_t index = 0; index < fileNames.size(); index++)
+  {
+    if (errors[index] != "")
+    {
+      throw std::runtime_error(DEBUG_INFO + " failed to load '" + fileNames[index] + "': " + errors[index]);
+    }
+  }
+  return histories;
+}
+
+}  // namespace starkit_utils
@@ -0,0 +1,187 @@
+#include "starkit_utils/history/history_log_writer.h"
+#include "starkit_utils/history/history_codec.h"
+#include "starkit_utils/util.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace starkit_utils
+{
+/**
+ * Size of the chunks written to the streams
+ */
+static const size_t chunkSize = 1 << 16;
+
+HistoryLogWriter::HistoryLogWriter() : _lastTicket(0), _lastDone(0), _stop(false)
+{
+  _thread = std::thread(&HistoryLogWriter::run, this);
+}
+
+HistoryLogWriter::~HistoryLogWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _jobsCondition.notify_one();
+  _thread.join();
+}
+
+uint64_t HistoryLogWriter::push(std::unique_ptr<std::deque<TimedValue>> values, std::shared_ptr<std::ostream> os,
+                                History::LogFormat format, double startTime)
+{
+  if (!values || !os)
+  {
+    throw std::logic_error(DEBUG_INFO + " null values or stream");
+  }
+  if (format != History::Ascii && format != History::Binary && format != History::Compressed)
+  {
+    throw std::logic_error(DEBUG_INFO + " unknown log format " + std::to_string(format));
+  }
+  uint64_t ticket;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ticket = ++_lastTicket;
+    _jobs.push_back(Job{ std::move(values), std::move(os), format, startTime, ticket });
+  }
+  _jobsCondition.notify_one();
+  return ticket;
+}
+
+bool HistoryLogWriter::isDone(uint64_t ticket) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _lastDone >= ticket;
+}
+
+void HistoryLogWriter::wait(uint64_t ticket)
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (ticket > _lastTicket)
+  {
+    throw std::logic_error(DEBUG_INFO + " ticket " + std::to_string(ticket) + " was not issued");
+  }
+  _doneCondition.wait(lock, [this, ticket]() { return _lastDone >= ticket; });
+  checkErrors(ticket, ticket);
+}
+
+void HistoryLogWriter::flush()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  uint64_t ticket = _lastTicket;
+  _doneCondition.wait(lock, [this, ticket]() { return _lastDone >= ticket; });
+  checkErrors(0, ticket);
+}
+
+size_t HistoryLogWriter::pendingJobs() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _lastTicket - _lastDone;
+}
+
+void HistoryLogWriter::checkErrors(uint64_t first, uint64_t last)
+{
+  auto it = _errors.lower_bound(first);
+  if (it != _errors.end() && it->first <= last)
+  {
+    std::string error = it->second;
+    _errors.erase(it);
+    throw std::runtime_error(DEBUG_INFO + error);
+  }
+}
+
+void HistoryLogWriter::run()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true)
+  {
+    _jobsCondition.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+    if (_jobs.empty())
+    {
+      // Stopping and nothing left to write
+      return;
+    }
+    Job job = std::move(_jobs.front());
+    _jobs.pop_front();
+    lock.unlock();
+
+    // Write without holding the lock, errors are reported to the waiter of the job
+    std::string error;
+    try
+    {
+      write(*job.values, *job.os, job.format, job.startTime);
+      job.os->flush();
+      if (job.os->fail())
+      {
+        error = " failed to write History log job " + std::to_string(job.ticket);
+      }
+    }
+    catch (const std::exception& e)
+    {
+      error = " History log job " + std::to_string(job.ticket) + ": " + e.what();
+    }
+    catch (...)
+    {
+      error = " History log job " + std::to_string(job.ticket) + ": unknown exception";
+    }
+    // Release memory and stream outside of the lock too
+    job.values.reset();
+    job.os.reset();
+
+    lock.lock();
+    if (!error.empty())
+    {
+      _errors[job.ticket] = error;
+    }
+    _lastDone = job.ticket;
+    _doneCondition.notify_all();
+  }
+}
+
+void HistoryLogWriter::write(const std::deque<TimedValue>& values, std::ostream& os, History::LogFormat format,
+                             double startTime)
+{
+  if (format == History::Compressed)
+  {
+    HistoryCodec::encode(values, os);
+    return;
+  }
+  if (format != History::Binary && format != History::Ascii)
+  {
+    throw std::logic_error("HistoryLogWriter unknown log format");
+  }
+  bool binary = format == History::Binary;
+  std::vector<char> buffer;
+  buffer.reserve(chunkSize + 64);
+  if (binary)
+  {
+    // When writing in binary, use all values
+    size_t size = values.size();
+    buffer.insert(buffer.end(), (const char*)&size, (const char*)&size + sizeof(size_t));
+  }
+  for (const auto& it : values)
+  {
+    if (binary)
+    {
+      buffer.insert(buffer.end(), (const char*)&(it.first), (const char*)&(it.first) + sizeof(double));
+      buffer.insert(buffer.end(), (const char*)&(it.second), (const char*)&(it.second) + sizeof(double));
+    }
+    // Skip data in buffer before logging start
+    else if (it.first >= startTime)
+    {
+      // Same output as std::setprecision(15)
+      char line[64];
+      int length = snprintf(line, sizeof(line), "%.15g %.15g\n", it.first, it.second);
+      buffer.insert(buffer.end(), line, line + length);
+    }
+    if (buffer.size() >= chunkSize)
+    {
+      os.write(buffer.data(), buffer.size());
+      buffer.clear();
+    }
+  }
+  os.write(buffer.data(), buffer.size());
+}
+
+}  // namespace starkit_utils
@@ -0,0 +1,136 @@
+#include "starkit_utils/history/history_pyramid.h"
+#include "starkit_utils/util.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace starkit_utils
+{
+HistoryPyramid::HistoryPyramid(size_t factor, size_t nbLevels) : _factor(factor), _levels(nbLevels), _pending(nbLevels)
+{
+  if (factor < 2 || nbLevels == 0)
+  {
+    throw std::logic_error(DEBUG_INFO + " invalid HistoryPyramid factor or number of levels");
+  }
+  size_t size = 1;
+  for (Pending& pending : _pending)
+  {
+    size *= factor;
+    pending.size = size;
+    pending.bucket.count = 0;
+  }
+}
+
+size_t HistoryPyramid::factor() const
+{
+  return _factor;
+}
+
+size_t HistoryPyramid::nbLevels() const
+{
+  return _levels.size();
+}
+
+void HistoryPyramid::push(double timestamp, double value)
+{
+  for (size_t k = 0; k < _levels.size(); k++)
+  {
+    Bucket& bucket = _pending[k].bucket;
+    if (bucket.count == 0)
+    {
+      bucket.tStart = timestamp;
+      bucket.min = value;
+      bucket.max = value;
+      bucket.mean = 0.0;
+    }
+    bucket.tEnd = timestamp;
+    bucket.min = std::min(bucket.min, value);
+    bucket.max = std::max(bucket.max, value);
+    bucket.mean += value;
+    bucket.count++;
+    if (bucket.count == _pending[k].size)
+    {
+      bucket.mean /= bucket.count;
+      _levels[k].push_back(bucket);
+      bucket.count = 0;
+    }
+  }
+}
+
+void HistoryPyramid::dropBefore(double timestamp)
+{
+  for (std::deque<Bucket>& level : _levels)
+  {
+    while (!level.empty() && level.front().tEnd < timestamp)
+    {
+      level.pop_front();
+    }
+  }
+}
+
+void HistoryPyramid::clear()
+{
+  for (size_t k = 0; k < _levels.size(); k++)
+  {
+    _levels[k].clear();
+    _pending[k].bucket.count = 0;
+  }
+}
+
+void HistoryPyramid::range(size_t level, double tStart, double tEnd, size_t& first, size_t& last) const
+{
+  if (level == 0 || level > _levels.size())
+  {
+    throw std::out_of_range(DEBUG_INFO + " invalid HistoryPyramid level " + std::to_string(level));
+  }
+  const std::deque<Bucket>& buckets = _levels[level - 1];
+  // Buckets are sorted by both tStart and tEnd
+  first = std::lower_bound(buckets.begin(), buckets.end(), tStart,
+                           [](const Bucket& bucket, double t) { return bucket.tEnd < t; }) -
+          buckets.begin();
+  last = std::upper_bound(buckets.begin(), buckets.end(), tEnd,
+                          [](double t, const Bucket& bucket) { return t < bucket.tStart; }) -
+         buckets.begin();
+  last = std::max(first, last);
+}
+
+bool HistoryPyramid::pendingOverlaps(size_t level, double tStart, double tEnd) const
+{
+  const Bucket& bucket = _pending[level - 1].bucket;
+  return bucket.count > 0 && bucket.tStart <= tEnd && bucket.tEnd >= tStart;
+}
+
+size_t HistoryPyramid::count(size_t level, double tStart, double tEnd) const
+{
+  size_t first, last;
+  range(level, tStart, tEnd, first, last);
+  return last - first + (pendingOverlaps(level, tStart, tEnd) ? 1 : 0);
+}
+
+void HistoryPyramid::query(size_t level, double tStart, double tEnd, std::vector<Bucket>& out) const
+{
+  size_t first, last;
+  range(level, tStart, tEnd, first, last);
+  const std::deque<Bucket>& buckets = _levels[level - 1];
+  out.insert(out.end(), buckets.begin() + first, buckets.begin() + last);
+  if (pendingOverlaps(level, tStart, tEnd))
+  {
+    Bucket bucket = _pending[level - 1].bucket;
+    bucket.mean /= bucket.count;
+    out.push_back(bucket);
+  }
+}
+
+std::vector<HistoryPyramid::Bucket> HistoryPyramid::query(double tStart, double tEnd, size_t maxPoints) const
+{
+  size_t level = 1;
+  while (level < _levels.size() && count(level, tStart, tEnd) > maxPoints)
+  {
+    level++;
+  }
+  std::vector<Bucket> out;
+  query(level, tStart, tEnd, out);
+  return out;
+}
+
+}  // namespace starkit_utils
@@ -0,0 +1,251 @@
+#include "starkit_utils/history/history_replayer.h"
+#include "starkit_utils/util.h"
+
+#include <chrono>
+
+namespace starkit_utils
+{
+const double HistoryReplayer::AsFastAsPossible = 0.0;
+
+HistoryReplayer::HistoryReplayer() : _speed(1.0), _paused(false), _stopped(false), _paceVersion(0), _time(0.0)
+{
+}
+
+size_t HistoryReplayer::addChannel(const std::string& name, History& history)
+{
+  std::deque<History::TimedValue> values = history.getValues();
+  std::lock_guard<std::mutex> lock(_mutex);
+  _channels.push_back(Channel{ name, std::vector<History::TimedValue>(values.begin(), values.end()), 0 });
+  rewindLocked();
+  return _channels.size() - 1;
+}
+
+size_t HistoryReplayer::nbChannels() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _channels.size();
+}
+
+std::string HistoryReplayer::getChannelName(size_t channel) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (channel >= _channels.size())
+  {
+    throw std::out_of_range(DEBUG_INFO + " invalid channel " + std::to_string(channel));
+  }
+  return _channels[channel].name;
+}
+
+void HistoryReplayer::addConsumer(Consumer consumer)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _consumers.push_back(consumer);
+}
+
+void HistoryReplayer::setSpeed(double speed)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _speed = speed;
+    _paceVersion++;
+  }
+  _condition.notify_all();
+}
+
+double HistoryReplayer::getSpeed() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _speed;
+}
+
+void HistoryReplayer::rewind()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    rewindLocked();
+  }
+  _condition.notify_all();
+}
+
+void HistoryReplayer::rewindLocked()
+{
+  _heap = decltype(_heap)();
+  for (size_t channel = 0; channel < _channels.size(); channel++)
+  {
+    _channels[channel].next = 0;
+    if (_channels[channel].values.size() > 0)
+    {
+      _heap.push(Head{ _channels[channel].values[0].first, channel });
+    }
+  }
+  _time = _heap.empty() ? 0.0 : _heap.top().timestamp;
+  _paceVersion++;
+}
+
+bool HistoryReplayer::popLocked(Event& event)
+{
+  if (_heap.empty())
+  {
+    return false;
+  }
+  Head head = _heap.top();
+  _heap.pop();
+  Channel& channel = _channels[head.channel];
+  event = Event{ head.channel, head.timestamp, channel.values[channel.next].second };
+  channel.next++;
+  if (channel.next < channel.values.size())
+  {
+    _heap.push(Head{ channel.values[channel.next].first, head.channel });
+  }
+  _time = event.timestamp;
+  return true;
+}
+
+void HistoryReplayer::publish(const Event& event)
+{
+  for (const Consumer& consumer : _consumers)
+  {
+    consumer(event);
+  }
+}
+
+bool HistoryReplayer::step()
+{
+  Event event;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!popLocked(event))
+    {
+      return false;
+    }
+    // The virtual clock moved, a concurrent run() takes a new reference
+    _paceVersion++;
+  }
+  _condition.notify_all();
+  publish(event);
+  return true;
+}
+
+size_t HistoryReplayer::stepUntil(double timestamp)
+{
+  size_t nbEvents = 0;
+  while (true)
+  {
+    Event event;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      if (_heap.empty() || _heap.top().timestamp > timestamp)
+      {
+        // The virtual clock reaches the requested time
+        if (_time < timestamp)
+        {
+          _time = timestamp;
+          _paceVersion++;
+        }
+        lock.unlock();
+        _condition.notify_all();
+        return nbEvents;
+      }
+      popLocked(event);
+      // The virtual clock moved, a concurrent run() takes a new reference
+      _paceVersion++;
+    }
+    publish(event);
+    nbEvents++;
+  }
+}
+
+void HistoryReplayer::run()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  // Real and virtual times of reference, updated when the pace changes
+  uint64_t paceVersion = _paceVersion - 1;
+  std::chrono::steady_clock::time_point realStart;
+  double virtualStart = 0.0;
+  while (true)
+  {
+    _condition.wait(lock, [this]() { return _stopped || !_paused; });
+    if (_stopped || _heap.empty())
+    {
+      break;
+    }
+    if (paceVersion != _paceVersion)
+    {
+      paceVersion = _paceVersion;
+      realStart = std::chrono::steady_clock::now();
+      virtualStart = _time;
+    }
+    if (_speed > 0.0)
+    {
+      std::chrono::duration<double> delay((_heap.top().timestamp - virtualStart) / _speed);
+      std::chrono::steady_clock::time_point target =
+          realStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay);
+      if (std::chrono::steady_clock::now() < target)
+      {
+        // Woken up early by pause, stop or pace changes
+        _condition.wait_until(lock, target);
+        continue;
+      }
+    }
+    Event event;
+    popLocked(event);
+    lock.unlock();
+    publish(event);
+    lock.lock();
+  }
+  _stopped = false;
+}
+
+void HistoryReplayer::pause()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _paused = true;
+  }
+  _condition.notify_all();
+}
+
+void HistoryReplayer::resume()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _paused = false;
+    _paceVersion++;
+  }
+  _condition.notify_all();
+}
+
+bool HistoryReplayer::isPaused() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _paused;
+}
+
+void HistoryReplayer::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopped = true;
+  }
+  _condition.notify_all();
+}
+
+bool HistoryReplayer::isOver() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _heap.empty();
+}
+
+double HistoryReplayer::getTime() const
+{
+  return _time;
+}
+
+TimeStamp HistoryReplayer::getTimeStamp() const
+{
+  std::chrono::duration<double> sinceEpoch(_time);
+  return TimeStamp(std::chrono::steady_clock::time_point(
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(sinceEpoch)));
+}
+
+}  // namespace starkit_utils
@@ -0,0 +1,341 @@
+#include "starkit_utils/history/history_ring.h"
+#include "starkit_utils/util.h"
+
+#include <limits>
+#include <new>
+
+namespace starkit_utils
+{
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "HistoryRing requires lock-free 64 bits atomics");
+static_assert(std::atomic<double>::is_always_lock_free, "HistoryRing requires lock-free double atomics");
+
+/**
+ * Offset of the first slot from the beginning of the memory area
+ */
+static size_t slotsOffset()
+{
+  return ((sizeof(HistoryRing::Header) + alignof(HistoryRing::Slot) - 1) / alignof(HistoryRing::Slot)) *
+         alignof(HistoryRing::Slot);
+}
+
+size_t HistoryRing::requiredBytes(size_t capacity)
+{
+  return slotsOffset() + capacity * sizeof(Slot);
+}
+
+HistoryRing::HistoryRing(size_t capacity, double window)
+  : _storage(new unsigned char[requiredBytes(capacity)]), _header(nullptr), _slots(nullptr)
+{
+  _header = reinterpret_cast<Header*>(_storage.get());
+  _slots = reinterpret_cast<Slot*>(_storage.get() + slotsOffset());
+  initialize(capacity, window);
+}
+
+HistoryRing::HistoryRing(void* memory, size_t capacity, double window, bool initialize)
+  : _storage(), _header(reinterpret_cast<Header*>(memory))
+  , _slots(reinterpret_cast<Slot*>(reinterpret_cast<unsigned char*>(memory) + slotsOffset()))
+{
+  if (initialize)
+  {
+    this->initialize(capacity, window);
+  }
+  else if (_header->capacity != capacity)
+  {
+    throw std::logic_error(DEBUG_INFO + " ring capacity mismatch: " + std::to_string(_header->capacity) +
+                           " != " + std::to_string(capacity));
+  }
+}
+
+void HistoryRing::initialize(size_t capacity, double window)
+{
+  if (capacity < 2)
+  {
+    throw std::logic_error(DEBUG_INFO + " ring capacity must be at least 2");
+  }
+  new (_header) Header();
+  _header->capacity = capacity;
+  _header->windowSize.store(window);
+  _header->start.store(0);
+  _header->end.store(0);
+  _header->lastTimestamp = 0.0;
+  for (size_t i = 0; i < capacity; i++)
+  {
+    new (&_slots[i]) Slot();
+    _slots[i].seq.store(0);
+    _slots[i].timestamp.store(0.0);
+    _slots[i].value.store(0.0);
+  }
+}
+
+size_t HistoryRing::capacity() const
+{
+  return _header->capacity;
+}
+
+bool HistoryRing::push(double timestamp, double value)
+{
+  uint64_t start = _header->start.load(std::memory_order_relaxed);
+  uint64_t end = _header->end.load(std::memory_order_relaxed);
+  // Check that timestamp is increasing
+  if (end > start && timestamp < _header->lastTimestamp)
+  {
+    throw std::logic_error("History invalid timestamp");
+  }
+  if (end > start && timestamp == _header->lastTimestamp)
+  {
+    return false;
+  }
+  // Write the slot, readers see an odd sequence until it is complete
+  uint64_t capacity = _header->capacity;
+  Slot& slot = _slots[end % capacity];
+  uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+  slot.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.timestamp.store(timestamp, std::memory_order_relaxed);
+  slot.value.store(value, std::memory_order_relaxed);
+  slot.seq.store(seq + 2, std::memory_order_release);
+  // Publish the point
+  end++;
+  _header->end.store(end, std::memory_order_release);
+  _header->lastTimestamp = timestamp;
+  // Shrink the window, the writer is the only one updating slots
+  if (end - start > capacity)
+  {
+    start = end - capacity;
+  }
+  double window = _header->windowSize.load(std::memory_order_relaxed);
+  while (end - start > 1 && timestamp - _slots[start % capacity].timestamp.load(std::memory_order_relaxed) > window)
+  {
+    start++;
+  }
+  _header->start.store(start, std::memory_order_release);
+  return true;
+}
+
+void HistoryRing::clear()
+{
+  _header->start.store(_header->end.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+void HistoryRing::setWindowSize(double window)
+{
+  _header->windowSize.store(window, std::memory_order_relaxed);
+}
+
+void HistoryRing::bounds(uint64_t& start, uint64_t& end) const
+{
+  while (true)
+  {
+    end = _header->end.load(std::memory_order_acquire);
+    start = _header->start.load(std::memory_order_acquire);
+    // Start may have been advanced after end was read
+    if (start > end)
+    {
+      continue;
+    }
+    if (end - start > _header->capacity)
+    {
+      start = end - _header->capacity;
+    }
+    return;
+  }
+}
+
+bool HistoryRing::read(uint64_t index, TimedValue& value) const
+{
+  const Slot& slot = _slots[index % _header->capacity];
+  uint64_t expected = 2 * (index / _header->capacity + 1);
+  uint64_t seqBefore = slot.seq.load(std::memory_order_acquire);
+  if (seqBefore != expected)
+  {
+    return false;
+  }
+  value.first = slot.timestamp.load(std::memory_order_relaxed);
+  value.second = slot.value.load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.seq.load(std::memory_order_relaxed) == seqBefore;
+}
+
+size_t HistoryRing::size() const
+{
+  uint64_t start, end;
+  bounds(start, end);
+  return end - start;
+}
+
+HistoryRing::TimedValue HistoryRing::front() const
+{
+  TimedValue value(0.0, 0.0);
+  while (true)
+  {
+    uint64_t start, end;
+    bounds(start, end);
+    if (start == end)
+    {
+      return TimedValue(0.0, 0.0);
+    }
+    if (read(start, value))
+    {
+      return value;
+    }
+  }
+}
+
+HistoryRing::TimedValue HistoryRing::back() const
+{
+  TimedValue value(0.0, 0.0);
+  while (true)
+  {
+    uint64_t start, end;
+    bounds(start, end);
+    if (start == end)
+    {
+      return TimedValue(0.0, 0.0);
+    }
+    if (read(end - 1, value))
+    {
+      return value;
+    }
+  }
+}
+
+bool HistoryRing::bracket(double timestamp, TimedValue& low, TimedValue& up, uint64_t* hint) const
+{
+  // Restart from fresh bounds whenever a slot has been overwritten
+  while (true)
+  {
+    uint64_t start, end;
+    bounds(start, end);
+    if (start == end)
+    {
+      return false;
+    }
+    if (!read(start, low) || !read(end - 1, up))
+    {
+      continue;
+    }
+    if (end - start == 1 || timestamp <= low.first)
+    {
+      up = low;
+      if (hint != nullptr)
+      {
+        *hint = start;
+      }
+      return true;
+    }
+    if (timestamp >= up.first)
+    {
+      low = up;
+      if (hint != nullptr)
+      {
+        *hint = end - 1;
+      }
+      return true;
+    }
+    uint64_t indexLow = start;
+    uint64_t indexUp = end - 1;
+    bool valid = true;
+    // Gallop forward from the hint
+    TimedValue probe(0.0, 0.0);
+    if (hint != nullptr && *hint >= start && *hint < end - 1 && read(*hint, probe) && probe.first <= timestamp)
+    {
+      indexLow = *hint;
+      low = probe;
+      uint64_t step = 1;
+      while (valid && indexLow + step < indexUp)
+      {
+        valid = read(indexLow + step, probe);
+        if (probe.first > timestamp)
+        {
+          indexUp = indexLow + step;
+          up = probe;
+          break;
+        }
+        indexLow += step;
+        low = probe;
+        step *= 2;
+      }
+    }
+    // Bijection search
+    while (valid && indexUp - indexLow > 1)
+    {
+      uint64_t indexMiddle = indexLow + (indexUp - indexLow) / 2;
+      TimedValue middle(0.0, 0.0);
+      valid = read(indexMiddle, middle);
+      if (middle.first <= timestamp)
+      {
+        indexLow = indexMiddle;
+        low = middle;
+      }
+      else
+      {
+        indexUp = indexMiddle;
+        up = middle;
+      }
+    }
+    if (valid)
+    {
+      if (hint != nullptr)
+      {
+        *hint = indexLow;
+      }
+      return true;
+    }
+  }
+}
+
+bool HistoryRing::neighbours(double timestamp, TimedValue points[4], uint64_t* hint) const
+{
+  uint64_t index = hint != nullptr ? *hint : std::numeric_limits<uint64_t>::max();
+  while (true)
+  {
+    if (!bracket(timestamp, points[1], points[2], &index))
+    {
+      return false;
+    }
+    points[0] = points[1];
+    points[3] = points[2];
+    if (points[1].first == points[2].first)
+    {
+      break;
+    }
+    // Neighbours dropped since the bracket are ignored, overwritten ones
+    // are detected by read and the search is restarted
+    uint64_t start, end;
+    bounds(start, end);
+    if ((index > start && !read(index - 1, points[0])) || (index + 2 < end && !read(index + 2, points[3])))
+    {
+      continue;
+    }
+    break;
+  }
+  if (hint != nullptr)
+  {
+    *hint = index;
+  }
+  return true;
+}
+
+std::deque<HistoryRing::TimedValue> HistoryRing::snapshot() const
+{
+  std::deque<TimedValue> values;
+  while (true)
+  {
+    values.clear();
+    uint64_t start, end;
+    bounds(start, end);
+    bool valid = true;
+    for (uint64_t index = start; valid && index < end; index++)
+    {
+      TimedValue value;
+      valid = read(index, value);
+      values.push_back(value);
+    }
+    if (valid)
+    {
+      return values;
+    }
+  }
+}
+
+}  // namespace starkit_utils
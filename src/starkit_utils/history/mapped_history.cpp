@@ -0,0 +1,136 @@
+#include "starkit_utils/history/mapped_history.h"
+#include "starkit_utils/util.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace starkit_utils
+{
+MappedHistory::MappedHistory(const std::string& path, double timeShift)
+  : _timeShift(timeShift), _mapping(nullptr), _mappingSize(0), _data(nullptr), _size(0)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw std::runtime_error(DEBUG_INFO + " failed to open '" + path + "': " + strerror(errno));
+  }
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0)
+  {
+    std::string error = strerror(errno);
+    close(fd);
+    throw std::runtime_error(DEBUG_INFO + " failed to stat '" + path + "': " + error);
+  }
+  _mappingSize = fileStat.st_size;
+  if (_mappingSize < sizeof(size_t))
+  {
+    close(fd);
+    throw std::runtime_error(DEBUG_INFO + " file '" + path + "' is too short to be a binary History log");
+  }
+  _mapping = mmap(nullptr, _mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+  if (_mapping == MAP_FAILED)
+  {
+    std::string error = strerror(errno);
+    _mapping = nullptr;
+    close(fd);
+    throw std::runtime_error(DEBUG_INFO + " failed to map '" + path + "': " + error);
+  }
+  // The mapping stays valid once the descriptor is closed
+  close(fd);
+  const unsigned char* bytes = static_cast<const unsigned char*>(_mapping);
+  memcpy(&_size, bytes, sizeof(size_t));
+  if (_size > (_mappingSize - sizeof(size_t)) / (2 * sizeof(double)))
+  {
+    munmap(_mapping, _mappingSize);
+    throw std::runtime_error(DEBUG_INFO + " file '" + path + "' is truncated: " + std::to_string(_size) +
+                             " points announced");
+  }
+  _data = reinterpret_cast<const double*>(bytes + sizeof(size_t));
+  // Accesses are bijection searches rather than sequential reads
+  madvise(_mapping, _mappingSize, MADV_RANDOM);
+}
+
+MappedHistory::~MappedHistory()
+{
+  if (_mapping != nullptr)
+  {
+    munmap(_mapping, _mappingSize);
+  }
+}
+
+size_t MappedHistory::size() const
+{
+  return _size;
+}
+
+double MappedHistory::timestampAt(size_t index) const
+{
+  return _data[2 * index] + _timeShift;
+}
+
+History::TimedValue MappedHistory::at(size_t index) const
+{
+  if (index >= _size)
+  {
+    throw std::out_of_range(DEBUG_INFO + " invalid index " + std::to_string(index));
+  }
+  return History::TimedValue(timestampAt(index), _data[2 * index + 1]);
+}
+
+History::TimedValue MappedHistory::front() const
+{
+  if (_size == 0)
+  {
+    return History::TimedValue(0.0, 0.0);
+  }
+  return at(0);
+}
+
+History::TimedValue MappedHistory::back() const
+{
+  if (_size == 0)
+  {
+    return History::TimedValue(0.0, 0.0);
+  }
+  return at(_size - 1);
+}
+
+double MappedHistory::interpolate(double timestamp, History::ValueType valueType) const
+{
+  // Degererate failback cases
+  if (_size == 0)
+  {
+    return 0.0;
+  }
+  else if (_size == 1 || timestamp <= timestampAt(0))
+  {
+    return _data[1];
+  }
+  else if (timestamp >= timestampAt(_size - 1))
+  {
+    return _data[2 * (_size - 1) + 1];
+  }
+
+  // Bijection search
+  size_t indexLow = 0;
+  size_t indexUp = _size - 1;
+  while (indexUp - indexLow > 1)
+  {
+    size_t indexMiddle = (indexLow + indexUp) / 2;
+    if (timestampAt(indexMiddle) <= timestamp)
+    {
+      indexLow = indexMiddle;
+    }
+    else
+    {
+      indexUp = indexMiddle;
+    }
+  }
+  return History::interpolateBracket(at(indexLow), at(indexUp), timestamp, valueType);
+}
+
+}  // namespace starkit_utils
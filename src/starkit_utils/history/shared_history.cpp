@@ -0,0 +1,187 @@
+#include "starkit_utils/history/shared_history.h"
+#include "starkit_utils/util.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace starkit_utils
+{
+/**
+ * POSIX shared memory names start with a slash
+ */
+static std::string segmentName(const std::string& name)
+{
+  if (name.size() > 0 && name[0] == '/')
+  {
+    return name;
+  }
+  return "/" + name;
+}
+
+SharedHistory::SharedHistory(const std::string& name, size_t capacity, double window)
+  : _name(segmentName(name)), _isWriter(true), _mapping(nullptr), _mappingSize(HistoryRing::requiredBytes(capacity))
+{
+  // Start from a fresh segment, readers of a previous one are not disturbed
+  shm_unlink(_name.c_str());
+  int fd = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0)
+  {
+    throw std::runtime_error(DEBUG_INFO + " failed to create shared memory '" + _name + "': " + strerror(errno));
+  }
+  if (ftruncate(fd, _mappingSize) != 0)
+  {
+    std::string error = strerror(errno);
+    close(fd);
+    shm_unlink(_name.c_str());
+    throw std::runtime_error(DEBUG_INFO + " failed to resize shared memory '" + _name + "': " + error);
+  }
+  _mapping = mmap(nullptr, _mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (_mapping == MAP_FAILED)
+  {
+    std::string error = strerror(errno);
+    _mapping = nullptr;
+    close(fd);
+    shm_unlink(_name.c_str());
+    throw std::runtime_error(DEBUG_INFO + " failed to map shared memory '" + _name + "': " + error);
+  }
+  close(fd);
+  try
+  {
+    _ring.reset(new HistoryRing(_mapping, capacity, window, true));
+  }
+  catch (...)
+  {
+    munmap(_mapping, _mappingSize);
+    shm_unlink(_name.c_str());
+    throw;
+  }
+}
+
+SharedHistory::SharedHistory(const std::string& name)
+  : _name(segmentName(name)), _isWriter(false), _mapping(nullptr), _mappingSize(0)
+{
+  int fd = shm_open(_name.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+  {
+    throw std::runtime_error(DEBUG_INFO + " failed to open shared memory '" + _name + "': " + strerror(errno));
+  }
+  struct stat segmentStat;
+  if (fstat(fd, &segmentStat) != 0)
+  {
+    std::string error = strerror(errno);
+    close(fd);
+    throw std::runtime_error(DEBUG_INFO + " failed to stat shared memory '" + _name + "': " + error);
+  }
+  _mappingSize = segmentStat.st_size;
+  if (_mappingSize < sizeof(HistoryRing::Header))
+  {
+    close(fd);
+    throw std::runtime_error(DEBUG_INFO + " shared memory '" + _name + "' is not initialized");
+  }
+  _mapping = mmap(nullptr, _mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+  if (_mapping == MAP_FAILED)
+  {
+    std::string error = strerror(errno);
+    _mapping = nullptr;
+    close(fd);
+    throw std::runtime_error(DEBUG_INFO + " failed to map shared memory '" + _name + "': " + error);
+  }
+  close(fd);
+  uint64_t capacity = static_cast<const HistoryRing::Header*>(_mapping)->capacity;
+  if (capacity < 2 || HistoryRing::requiredBytes(capacity) > _mappingSize)
+  {
+    munmap(_mapping, _mappingSize);
+    throw std::runtime_error(DEBUG_INFO + " shared memory '" + _name + "' is not initialized");
+  }
+  // The ring is only read through this mapping
+  _ring.reset(new HistoryRing(_mapping, capacity, 0.0, false));
+}
+
+SharedHistory::~SharedHistory()
+{
+  _ring.reset();
+  if (_mapping != nullptr)
+  {
+    munmap(_mapping, _mappingSize);
+  }
+  if (_isWriter)
+  {
+    shm_unlink(_name.c_str());
+  }
+}
+
+bool SharedHistory::isWriter() const
+{
+  return _isWriter;
+}
+
+const std::string& SharedHistory::getName() const
+{
+  return _name;
+}
+
+size_t SharedHistory::capacity() const
+{
+  return _ring->capacity();
+}
+
+void SharedHistory::checkWriter(const std::string& operation) const
+{
+  if (!_isWriter)
+  {
+    throw std::logic_error(DEBUG_INFO + " " + operation + " is not available on SharedHistory reader '" + _name + "'");
+  }
+}
+
+void SharedHistory::setWindowSize(double window)
+{
+  checkWriter("setWindowSize");
+  _ring->setWindowSize(window);
+}
+
+void SharedHistory::pushValue(double timestamp, double value)
+{
+  checkWriter("pushValue");
+  _ring->push(timestamp, value);
+}
+
+size_t SharedHistory::size() const
+{
+  return _ring->size();
+}
+
+History::TimedValue SharedHistory::front() const
+{
+  return _ring->front();
+}
+
+History::TimedValue SharedHistory::back() const
+{
+  return _ring->back();
+}
+
+double SharedHistory::interpolate(double timestamp, History::ValueType valueType) const
+{
+  History::TimedValue low, up;
+  if (!_ring->bracket(timestamp, low, up))
+  {
+    return 0.0;
+  }
+  return History::interpolateBracket(low, up, timestamp, valueType);
+}
+
+double SharedHistory::interpolate(double timestamp, History::Kernel kernel, History::ValueType valueType) const
+{
+  History::TimedValue points[4];
+  if (!_ring->neighbours(timestamp, points))
+  {
+    return 0.0;
+  }
+  return History::interpolateNeighbours(points, timestamp, kernel, valueType);
+}
+
+}  // namespace starkit_utils
@@ -1,8 +1,13 @@
 
 set(SOURCES
     chrono.cpp
+    bench.cpp
     benchmark.cpp
+    benchmark_snapshot_writer.cpp
     elapse_tick.cpp
+    latency_histogram.cpp
+    perf_counters.cpp
     sleep.cpp
     time_stamp.cpp
+    tsc_clock.cpp
     )
@@ -0,0 +1,291 @@
+#include "starkit_utils/timing/bench.h"
+
+#include "starkit_utils/timing/benchmark.h"
+#include "starkit_utils/timing/tsc_clock.h"
+#include "starkit_utils/util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace starkit_utils
+{
+namespace bench
+{
+/**
+ * Median of values, which are sorted
+ */
+static double median(std::vector<double>& values)
+{
+  if (values.size() == 0)
+  {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  size_t middle = values.size() / 2;
+  return values.size() % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+double Result::percentile(double ratio) const
+{
+  if (samples.size() == 0)
+  {
+    return 0;
+  }
+  std::vector<double> sorted = samples;
+  std::sort(sorted.begin(), sorted.end());
+  size_t rank = std::max<size_t>(1, std::ceil(ratio * sorted.size()));
+  return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+uint64_t nextIterations(uint64_t nbIterations, double elapsed, const Options& options)
+{
+  double factor = elapsed > 0 ? 1.2 * options.sampleTime / elapsed : 10;
+  factor = std::min(10.0, std::max(1.5, factor));
+  return std::min<uint64_t>(options.maxIterationsPerSample, std::ceil(nbIterations * factor));
+}
+
+Sampler::Sampler(const std::string& name, uint64_t nbIterations)
+  : internedName(Benchmark::intern(name)), nbIterations(nbIterations), startTicks(0), counted(false)
+  , nbCountedSamples(0), countersMask(0)
+{
+  result.name = name;
+  result.iterationsPerSample = nbIterations;
+  counterTotals.fill(0);
+}
+
+const std::string* Sampler::getInternedName() const
+{
+  return internedName;
+}
+
+void Sampler::start()
+{
+  counted = Benchmark::readCounters(&startCounters, &countersMask);
+  startTicks = TscClock::now();
+}
+
+void Sampler::stop()
+{
+  uint64_t stopTicks = TscClock::now();
+  PerfCounters::Values stopCounters;
+  if (counted && Benchmark::readCounters(&stopCounters))
+  {
+    for (int i = 0; i < PerfCounters::NbCounters; i++)
+    {
+      counterTotals[i] += stopCounters[i] - startCounters[i];
+    }
+    nbCountedSamples++;
+  }
+  result.samples.push_back(TscClock::toSeconds(stopTicks - startTicks) / nbIterations);
+}
+
+Result Sampler::finish(std::ostream* log)
+{
+  std::vector<double> values = result.samples;
+  result.median = median(values);
+  for (double& value : values)
+  {
+    value = std::fabs(value - result.median);
+  }
+  result.mad = median(values);
+
+  result.counters.fill(std::nan(""));
+  if (nbCountedSamples > 0)
+  {
+    for (int i = 0; i < PerfCounters::NbCounters; i++)
+    {
+      if (countersMask & (1 << i))
+      {
+        result.counters[i] = double(counterTotals[i]) / (double(nbCountedSamples) * nbIterations);
+      }
+    }
+  }
+
+  if (log != NULL)
+  {
+    *log << result.name << ": " << result.median * 1e9 << " ns/it +- " << result.mad * 1e9 << " ns (MAD), "
+         << result.samples.size() << " samples of " << nbIterations << " iterations" << std::endl;
+  }
+  return result;
+}
+
+void writeCSV(std::ostream& out, const std::vector<Result>& results)
+{
+  // The mad column comes after the columns of Benchmark
+  std::ostringstream header;
+  Benchmark::printCSVHeader(header);
+  std::string columns = header.str();
+  out << columns.substr(0, columns.find('\n')) << ",mad" << std::endl;
+  for (const Result& result : results)
+  {
+    double time = 0;
+    for (double sample : result.samples)
+    {
+      time += sample * result.iterationsPerSample;
+    }
+    out << 0 << "," << result.name << ",unknown," << time << ","
+        << result.iterationsPerSample * result.samples.size() << "," << result.percentile(0.5) << ","
+        << result.percentile(0.9) << "," << result.percentile(0.99) << "," << result.percentile(0.999) << ","
+        << result.percentile(1.0);
+    if (Benchmark::areCountersEnabled())
+    {
+      double values[] = { result.counters[PerfCounters::Instructions] / result.counters[PerfCounters::Cycles],
+                          result.counters[PerfCounters::LLCMisses], result.counters[PerfCounters::BranchMisses],
+                          result.counters[PerfCounters::ContextSwitches] };
+      for (double value : values)
+      {
+        out << ",";
+        if (!std::isnan(value))
+          out << value;
+      }
+    }
+    out << "," << result.mad << std::endl;
+  }
+}
+
+/**
+ * Fields of a csv line
+ */
+static std::vector<std::string> split(const std::string& line)
+{
+  std::vector<std::string> fields;
+  std::istringstream iss(line);
+  std::string field;
+  while (std::getline(iss, field, ','))
+  {
+    fields.push_back(field);
+  }
+  return fields;
+}
+
+struct Row
+{
+  double p50;
+  double p90;
+  /**
+   * NaN for files written by Benchmark::printCSV
+   */
+  double mad;
+};
+
+/**
+ * Root rows of a csv written by writeCSV, in file order
+ */
+static std::vector<std::pair<std::string, Row>> readCSV(std::istream& in)
+{
+  std::string line;
+  if (!std::getline(in, line))
+  {
+    throw std::runtime_error(DEBUG_INFO + " empty csv");
+  }
+  std::vector<std::string> header = split(line);
+  std::map<std::string, size_t> columns;
+  for (size_t i = 0; i < header.size(); i++)
+  {
+    columns[header[i]] = i;
+  }
+  for (const char* column : { "depth", "name", "p50", "p90" })
+  {
+    if (columns.count(column) == 0)
+    {
+      throw std::runtime_error(DEBUG_INFO + " missing column '" + column + "'");
+    }
+  }
+  std::vector<std::pair<std::string, Row>> rows;
+  while (std::getline(in, line))
+  {
+    std::vector<std::string> fields = split(line);
+    if (fields.size() == 0 || fields.size() <= columns["p90"] || fields[columns["depth"]] != "0")
+    {
+      continue;
+    }
+    try
+    {
+      Row row{ std::stod(fields[columns["p50"]]), std::stod(fields[columns["p90"]]), std::nan("") };
+      if (columns.count("mad") > 0 && fields.size() > columns["mad"] && fields[columns["mad"]] != "")
+      {
+        row.mad = std::stod(fields[columns["mad"]]);
+      }
+      rows.push_back(std::make_pair(fields[columns["name"]], row));
+    }
+    catch (const std::logic_error&)
+    {
+      throw std::runtime_error(DEBUG_INFO + " invalid line '" + line + "'");
+    }
+  }
+  return rows;
+}
+
+std::vector<Comparison> compare(std::istream& before, std::istream& after, double threshold, double nbSigmas)
+{
+  std::vector<std::pair<std::string, Row>> beforeRows = readCSV(before);
+  std::map<std::string, Row> beforeByName(beforeRows.begin(), beforeRows.end());
+  std::vector<Comparison> comparisons;
+  for (const auto& afterRow : readCSV(after))
+  {
+    auto it = beforeByName.find(afterRow.first);
+    if (it == beforeByName.end())
+    {
+      continue;
+    }
+    const Row& b = it->second;
+    const Row& a = afterRow.second;
+    Comparison comparison;
+    comparison.name = afterRow.first;
+    comparison.before = b.p50;
+    comparison.after = a.p50;
+    comparison.ratio = b.p50 > 0 ? a.p50 / b.p50 : std::nan("");
+    double noise;
+    if (!std::isnan(b.mad) && !std::isnan(a.mad))
+    {
+      // Robust standard deviation from the MAD, not inflated by the
+      // right tail of timing distributions
+      noise = 1.4826 * std::max(b.mad, a.mad);
+    }
+    else
+    {
+      // Standard deviation of a normal distribution from its p50 and p90
+      noise = std::max(b.p90 - b.p50, a.p90 - a.p50) / 1.2816;
+    }
+    comparison.significant =
+        std::fabs(comparison.ratio - 1) > threshold && std::fabs(a.p50 - b.p50) > nbSigmas * noise;
+    comparison.regression = comparison.significant && a.p50 > b.p50;
+    comparisons.push_back(comparison);
+  }
+  return comparisons;
+}
+
+int printComparisons(std::ostream& out, const std::vector<Comparison>& comparisons)
+{
+  int nbRegressions = 0;
+  std::ios::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+  out.setf(std::ios::fixed, std::ios::floatfield);
+  out.precision(3);
+  for (const Comparison& comparison : comparisons)
+  {
+    out << std::setw(12) << comparison.before * 1e9 << " ns -> " << std::setw(12) << comparison.after * 1e9
+        << " ns " << std::showpos << std::setw(8) << (comparison.ratio - 1) * 100 << std::noshowpos << " % : "
+        << comparison.name;
+    if (comparison.regression)
+    {
+      out << " REGRESSION";
+      nbRegressions++;
+    }
+    else if (comparison.significant)
+    {
+      out << " improvement";
+    }
+    out << std::endl;
+  }
+  out.flags(flags);
+  out.precision(precision);
+  return nbRegressions;
+}
+
+}  // namespace bench
+}  // namespace starkit_utils
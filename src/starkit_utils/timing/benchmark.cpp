@@ -3,6 +3,8 @@
 #include "starkit_utils/util.h"
 
 #include <algorithm>
+#include <cmath>
+#include <deque>
 #include <exception>
 #include <iomanip>
 #include <sstream>
@@ -12,16 +14,139 @@
 #include <ctime>
 #include <cstdlib>
 #include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <unistd.h>
 
 using namespace std::chrono;
 
 namespace starkit_utils
 {
+struct Benchmark::ThreadRecord
+{
+  /**
+   * Protects tree, never taken when closing a root
+   */
+  std::mutex mutex;
+
+  /**
+   * Named after the thread, its children are the closed root benchmarks
+   * taken from pending
+   */
+  std::unique_ptr<Benchmark> tree;
+
+  /**
+   * Closed root benchmarks not taken yet. The owning thread exchanges it
+   * with NULL while merging a root into it, and readers exchange it with
+   * NULL to take it, so that it is never accessed by two threads
+   */
+  std::atomic<Benchmark*> pending;
+
+  /**
+   * Index of the thread in the registry, used as trace thread id
+   */
+  size_t index;
+
+  struct TraceEvent
+  {
+    const std::string* name;
+    uint64_t ticks;
+    char phase;
+  };
+
+  /**
+   * Trace events, only written by the owning thread. Entries below
+   * nbEvents are complete and may be read by other threads holding
+   * mutex. The buffer is only reallocated by its owner holding mutex
+   */
+  std::vector<TraceEvent> events;
+  std::atomic<size_t> nbEvents;
+  std::atomic<uint64_t> nbDropped;
+  uint64_t traceGeneration;
+
+  struct SnapshotSlot
+  {
+    uint64_t startTicks;
+    uint64_t endTicks;
+    size_t nbEntries;
+    size_t nbTruncated;
+    std::vector<SnapshotEntry> entries;
+  };
+
+  /**
+   * Snapshot ring, only written by the owning thread. Slots between
+   * snapshotTail and snapshotHead are complete and may be popped by
+   * other threads holding snapshotMutex. The ring is only reallocated
+   * by its owner holding snapshotMutex
+   */
+  std::mutex snapshotMutex;
+  std::vector<SnapshotSlot> snapshots;
+  std::atomic<uint64_t> snapshotHead;
+  std::atomic<uint64_t> snapshotTail;
+  std::atomic<uint64_t> nbDelayedSnapshots;
+  uint64_t snapshotGeneration;
+  /**
+   * Only used by the owning thread
+   */
+  uint64_t lastSnapshotTicks;
+  uint64_t nextSnapshotTicks;
+
+  ThreadRecord(size_t index)
+    : pending(NULL), index(index), nbEvents(0), nbDropped(0), traceGeneration(0), snapshotHead(0), snapshotTail(0)
+    , nbDelayedSnapshots(0), snapshotGeneration(0), lastSnapshotTicks(0), nextSnapshotTicks(0)
+  {
+  }
+
+  ~ThreadRecord()
+  {
+    delete pending.load();
+  }
+};
+
+struct Benchmark::Arena
+{
+  /**
+   * Node storage, allocated by chunks, nodes never move
+   */
+  std::deque<Benchmark> nodes;
+
+  /**
+   * Released nodes, reused before allocating new ones
+   */
+  std::vector<Benchmark*> freeNodes;
+
+  /**
+   * Closed root trees by name
+   */
+  std::map<std::string, Benchmark*> roots;
+
+  /**
+   * Opened at the first counted session
+   */
+  std::unique_ptr<PerfCounters> counters;
+};
+
 /* Static variables */
-Benchmark* Benchmark::current = NULL;
+thread_local Benchmark* Benchmark::current = NULL;
+thread_local std::shared_ptr<Benchmark::ThreadRecord> Benchmark::threadRecord;
+std::mutex Benchmark::registryMutex;
+std::vector<std::shared_ptr<Benchmark::ThreadRecord>> Benchmark::registry;
+std::atomic<bool> Benchmark::tracing(false);
+std::atomic<size_t> Benchmark::traceCapacity(0);
+std::atomic<uint64_t> Benchmark::traceGeneration(0);
+std::atomic<bool> Benchmark::counting(false);
+std::atomic<bool> Benchmark::snapshotting(false);
+std::atomic<uint64_t> Benchmark::snapshotPeriod(0);
+std::atomic<size_t> Benchmark::snapshotCapacity(0);
+std::atomic<size_t> Benchmark::snapshotNbSlots(0);
+std::atomic<uint64_t> Benchmark::snapshotGeneration(0);
 
-Benchmark::Benchmark(Benchmark* f, const std::string& n) : father(f), name(n), elapsedTicks(0), nbIterations(0)
+Benchmark::Benchmark(Benchmark* f, const std::string& n)
+  : father(f), name(n), openingTicks(0), closingTicks(0), elapsedTicks(0), nbIterations(0), internedName(NULL)
+  , pooled(false), nbCountedIterations(0), countersMask(0), countingSession(false), snapshotTicks(0)
+  , snapshotIterations(0)
 {
+  counterTotals.fill(0);
   startSession();
 }
 
@@ -32,41 +157,190 @@ Benchmark* Benchmark::getCurrent()
   return current;
 }
 
+Benchmark* Benchmark::getActive()
+{
+  return current;
+}
+
 Benchmark::~Benchmark()
 {
+  // Children of pooled nodes belong to the arena
+  if (!pooled)
+  {
+    for (auto& c : children)
+    {
+      delete (c.second);
+    }
+  }
+}
+
+Benchmark::Arena& Benchmark::getArena()
+{
+  thread_local Arena arena;
+  return arena;
+}
+
+Benchmark* Benchmark::acquire(Benchmark* father, const std::string& name)
+{
+  Arena& arena = getArena();
+  Benchmark* node;
+  if (arena.freeNodes.empty())
+  {
+    arena.nodes.emplace_back(father, name);
+    node = &arena.nodes.back();
+    node->pooled = true;
+    node->startSession();
+  }
+  else
+  {
+    node = arena.freeNodes.back();
+    arena.freeNodes.pop_back();
+    node->father = father;
+    node->name = name;
+    node->startSession();
+  }
+  return node;
+}
+
+void Benchmark::release(Benchmark* node)
+{
+  for (auto& c : node->children)
+  {
+    release(c.second);
+  }
+  node->children.clear();
+  node->internedChildren.clear();
+  node->internedName = NULL;
+  node->resetStats();
+  node->snapshotTicks = 0;
+  node->snapshotIterations = 0;
+  getArena().freeNodes.push_back(node);
+}
+
+Benchmark* Benchmark::openRoot(const std::string& name)
+{
+  Arena& arena = getArena();
+  auto it = arena.roots.find(name);
+  if (it != arena.roots.end())
+  {
+    it->second->resetStats();
+    it->second->startSession();
+    return it->second;
+  }
+  Benchmark* root = acquire(NULL, name);
+  arena.roots[name] = root;
+  return root;
+}
+
+void Benchmark::resetStats()
+{
+  elapsedTicks = 0;
+  nbIterations = 0;
+  latencies.clear();
+  counterTotals.fill(0);
+  nbCountedIterations = 0;
+  countersMask = 0;
   for (auto& c : children)
   {
-    delete (c.second);
+    c.second->resetStats();
+  }
+}
+
+bool Benchmark::isStale() const
+{
+  return pooled && nbIterations == 0 && current != this;
+}
+
+void Benchmark::resetArena()
+{
+  if (current != NULL)
+  {
+    throw std::runtime_error(DEBUG_INFO + " can not reset the arena while '" + current->name + "' is open");
+  }
+  Arena& arena = getArena();
+  for (auto& root : arena.roots)
+  {
+    release(root.second);
+  }
+  arena.roots.clear();
+}
+
+size_t Benchmark::getNbArenaNodes()
+{
+  return getArena().nodes.size();
+}
+
+size_t Benchmark::getNbFreeArenaNodes()
+{
+  return getArena().freeNodes.size();
+}
+
+PerfCounters* Benchmark::getThreadCounters()
+{
+  Arena& arena = getArena();
+  if (!arena.counters)
+  {
+    arena.counters.reset(new PerfCounters());
   }
+  return arena.counters->isAvailable() ? arena.counters.get() : NULL;
 }
 
 void Benchmark::startSession()
 {
+  // Only nodes of the thread arena are actually opened
+  countingSession = false;
+  if (pooled && counting.load(std::memory_order_relaxed))
+  {
+    PerfCounters* counters = getThreadCounters();
+    if (counters != NULL)
+    {
+      counters->read(openingCounters);
+      countingSession = true;
+    }
+  }
 #ifndef WIN32
-  openingTime = steady_clock::now();
+  openingTicks = TscClock::now();
 #endif
 }
 
 void Benchmark::endSession()
 {
 #ifndef WIN32
-  closingTime = steady_clock::now();
+  closingTicks = TscClock::now();
 #endif
-  elapsedTicks += double((closingTime - openingTime).count());
+  uint64_t ticks = closingTicks - openingTicks;
+  elapsedTicks += double(ticks);
   nbIterations++;
+  latencies.record(ticks);
+  snapshotTicks += ticks;
+  snapshotIterations++;
+  if (countingSession)
+  {
+    PerfCounters* counters = getThreadCounters();
+    PerfCounters::Values closingCounters;
+    counters->read(closingCounters);
+    for (int i = 0; i < PerfCounters::NbCounters; i++)
+    {
+      counterTotals[i] += closingCounters[i] - openingCounters[i];
+    }
+    nbCountedIterations++;
+    countersMask |= counters->getAvailableMask();
+    countingSession = false;
+  }
 }
 
 void Benchmark::open(const std::string& benchmarkName)
 {
   // If child is not existing yet:
   Benchmark* childBenchmark = NULL;
-  if (current == NULL || current->children.count(benchmarkName) == 0)
+  if (current == NULL)
   {
-    childBenchmark = new Benchmark(current, benchmarkName);
-    if (current != NULL)
-    {
-      current->children[benchmarkName] = childBenchmark;
-    }
+    childBenchmark = openRoot(benchmarkName);
+  }
+  else if (current->children.count(benchmarkName) == 0)
+  {
+    childBenchmark = acquire(current, benchmarkName);
+    current->children[benchmarkName] = childBenchmark;
   }
   else
   {
@@ -74,6 +348,99 @@ void Benchmark::open(const std::string& benchmarkName)
     childBenchmark->startSession();
   }
   current = childBenchmark;
+  trace(childBenchmark, 'B', childBenchmark->openingTicks);
+}
+
+void Benchmark::open(const std::string* name)
+{
+  Benchmark* childBenchmark = NULL;
+  if (current != NULL)
+  {
+    for (const auto& c : current->internedChildren)
+    {
+      if (c.first == name)
+      {
+        childBenchmark = c.second;
+        break;
+      }
+    }
+    if (childBenchmark == NULL)
+    {
+      // First interned open of this child, which may have been opened by name
+      Benchmark*& child = current->children[*name];
+      if (child == NULL)
+      {
+        child = acquire(current, *name);
+      }
+      else
+      {
+        child->startSession();
+      }
+      childBenchmark = child;
+      current->internedChildren.push_back(std::make_pair(name, childBenchmark));
+    }
+    else
+    {
+      childBenchmark->startSession();
+    }
+  }
+  else
+  {
+    childBenchmark = openRoot(*name);
+  }
+  childBenchmark->internedName = name;
+  current = childBenchmark;
+  trace(childBenchmark, 'B', childBenchmark->openingTicks);
+}
+
+const std::string* Benchmark::intern(const std::string& name)
+{
+  // Interned names are never freed
+  static std::mutex internMutex;
+  static std::unordered_set<std::string> interned;
+  std::lock_guard<std::mutex> lock(internMutex);
+  return &(*interned.insert(name).first);
+}
+
+void Benchmark::closeScope(const Benchmark* scope)
+{
+  // Benchmarks opened inside the scope may have been left open by an exception
+  Benchmark* b = current;
+  while (b != NULL && b != scope)
+  {
+    b = b->father;
+  }
+  if (b == NULL)
+  {
+    // Already closed
+    return;
+  }
+  while (current != scope)
+  {
+    closeCurrent();
+  }
+  closeCurrent();
+}
+
+Benchmark* Benchmark::closeCurrent()
+{
+  if (current == NULL)
+    throw std::runtime_error("No active benchmark to close");
+  Benchmark* toClose = current;
+  toClose->endSession();
+  trace(toClose, 'E', toClose->closingTicks);
+  if (snapshotting.load(std::memory_order_relaxed))
+  {
+    snapshot(toClose->closingTicks, false);
+  }
+
+  current = toClose->father;
+  // Publish Benchmark if the link is lost, the arena keeps it for reuse
+  if (current == NULL)
+  {
+    publish(toClose);
+  }
+  return toClose;
 }
 
 double Benchmark::close(const char* expectedName, bool print, int detailLevel, std::ostream& out)
@@ -95,24 +462,12 @@ double Benchmark::close(const char* expectedName, bool print, int detailLevel, s
 
 double Benchmark::close(bool print, int detailLevel, std::ostream& out)
 {
-  if (current == NULL)
-    throw std::runtime_error("No active benchmark to close");
-  Benchmark* toClose = current;
-  toClose->endSession();
-
-  current = toClose->father;
+  Benchmark* toClose = closeCurrent();
   if (print)
   {
     toClose->print(out, detailLevel);
   }
-
-  double elapsedTime = toClose->getTime();
-  // Suppress Benchmark if the link is lost
-  if (current == NULL)
-  {
-    delete (toClose);
-  }
-  return elapsedTime;
+  return toClose->getTime();
 }
 
 double Benchmark::closeUntil(const std::string& stopName)
@@ -131,10 +486,29 @@ double Benchmark::closeUntil(const std::string& stopName)
 
 double Benchmark::getTime() const
 {
-  double time = elapsedTicks * steady_clock::period::num / steady_clock::period::den;
+  double time = TscClock::toSeconds(elapsedTicks);
   return time;
 }
 
+double Benchmark::getPercentile(double ratio) const
+{
+  return TscClock::toSeconds(latencies.percentile(ratio));
+}
+
+double Benchmark::getCounterPerIteration(PerfCounters::Counter counter) const
+{
+  if (nbCountedIterations == 0 || (countersMask & (1 << counter)) == 0)
+  {
+    return std::nan("");
+  }
+  return double(counterTotals[counter]) / nbCountedIterations;
+}
+
+double Benchmark::getIPC() const
+{
+  return getCounterPerIteration(PerfCounters::Instructions) / getCounterPerIteration(PerfCounters::Cycles);
+}
+
 double Benchmark::getSubTime() const
 {
   double t = 0;
@@ -175,7 +549,10 @@ void Benchmark::print(std::ostream& out, int depth, int width, int maxDepth)
   std::vector<printableEntry> subFields;
   for (auto& c : children)
   {
-    subFields.push_back(printableEntry(c.first, c.second->getTime(), c.second));
+    if (!c.second->isStale())
+    {
+      subFields.push_back(printableEntry(c.first, c.second->getTime(), c.second));
+    }
   }
   // Add Unknown field only if there are other information
   if (subFields.size() > 0)
@@ -205,8 +582,25 @@ void Benchmark::print(std::ostream& out, int depth, int width, int maxDepth)
   }
   for (int i = 0; i < depth; i++)
     out << "    ";
-  out << std::setw(width) << getTime() * 1000 << " ms : " << name << " (" << nbIterations << " iterations)"
-      << std::endl;
+  out << std::setw(width) << getTime() * 1000 << " ms : " << name << " (" << nbIterations << " iterations";
+  if (latencies.count() > 0)
+  {
+    out << ", p50 " << getPercentile(0.5) * 1000 << " ms, p90 " << getPercentile(0.9) * 1000 << " ms, p99 "
+        << getPercentile(0.99) * 1000 << " ms, p99.9 " << getPercentile(0.999) * 1000 << " ms, max "
+        << getPercentile(1.0) * 1000 << " ms";
+  }
+  if (nbCountedIterations > 0)
+  {
+    if (!std::isnan(getIPC()))
+      out << ", IPC " << getIPC();
+    if (countersMask & (1 << PerfCounters::LLCMisses))
+      out << ", LLC misses " << getCounterPerIteration(PerfCounters::LLCMisses) << "/it";
+    if (countersMask & (1 << PerfCounters::BranchMisses))
+      out << ", branch misses " << getCounterPerIteration(PerfCounters::BranchMisses) << "/it";
+    if (countersMask & (1 << PerfCounters::ContextSwitches))
+      out << ", context switches " << getCounterPerIteration(PerfCounters::ContextSwitches) << "/it";
+  }
+  out << ")" << std::endl;
 }
 
 double Benchmark::closeCSV(const std::string& path, int detailLevel)
@@ -220,12 +614,8 @@ double Benchmark::closeCSV(const std::string& path, int detailLevel)
 
 double Benchmark::closeCSV(std::ostream& out, bool header, int detailLevel)
 {
-  if (current == NULL)
-    throw std::runtime_error("No active benchmark to close");
-  Benchmark* toClose = current;
   // Close the benchmark
-  toClose->endSession();
-  current = toClose->father;
+  Benchmark* toClose = closeCurrent();
   // Print header if specified
   if (header)
     printCSVHeader(out);
@@ -236,7 +626,12 @@ double Benchmark::closeCSV(std::ostream& out, bool header, int detailLevel)
 
 void Benchmark::printCSVHeader(std::ostream& out)
 {
-  out << "depth,name,father,time" << std::endl;
+  out << "depth,name,father,time,iterations,p50,p90,p99,p99.9,max";
+  if (counting)
+  {
+    out << ",ipc,llc_misses,branch_misses,context_switches";
+  }
+  out << std::endl;
 }
 
 void Benchmark::printCSV(std::ostream& out, int depth, int maxDepth)
@@ -246,20 +641,585 @@ void Benchmark::printCSV(std::ostream& out, int depth, int maxDepth)
   if (father != NULL)
     fatherName = father->name;
   // Printing current informations
-  out << depth << "," << name << "," << fatherName << "," << getTime() << std::endl;
+  out << depth << "," << name << "," << fatherName << "," << getTime() << "," << nbIterations << ","
+      << getPercentile(0.5) << "," << getPercentile(0.9) << "," << getPercentile(0.99) << "," << getPercentile(0.999)
+      << "," << getPercentile(1.0);
+  if (counting)
+  {
+    // Empty fields for unavailable counters
+    double values[] = { getIPC(), getCounterPerIteration(PerfCounters::LLCMisses),
+                        getCounterPerIteration(PerfCounters::BranchMisses),
+                        getCounterPerIteration(PerfCounters::ContextSwitches) };
+    for (double value : values)
+    {
+      out << ",";
+      if (!std::isnan(value))
+        out << value;
+    }
+  }
+  out << std::endl;
 
-  // Print childrens if allowed and found
-  if (children.size() > 0 && (maxDepth < 0 || depth < maxDepth))
+  // Print childrens if allowed and found, stale ones are ignored
+  std::vector<Benchmark*> liveChildren;
+  for (auto& c : children)
   {
-    for (auto& c : children)
+    if (!c.second->isStale())
     {
-      c.second->printCSV(out, depth + 1, maxDepth);
+      liveChildren.push_back(c.second);
+    }
+  }
+  if (liveChildren.size() > 0 && (maxDepth < 0 || depth < maxDepth))
+  {
+    for (Benchmark* child : liveChildren)
+    {
+      child->printCSV(out, depth + 1, maxDepth);
     }
     // Print the unknown part
     double unknownTime = getTime() - getSubTime();
     out << (depth + 1) << ","
         << "unknown"
-        << "," << name << "," << unknownTime << std::endl;
+        << "," << name << "," << unknownTime << ",,,,,," << (counting ? ",,,," : "") << std::endl;
+  }
+}
+
+void Benchmark::merge(Benchmark* dst, const Benchmark* src)
+{
+  dst->elapsedTicks += src->elapsedTicks;
+  dst->nbIterations += src->nbIterations;
+  dst->latencies.merge(src->latencies);
+  for (int i = 0; i < PerfCounters::NbCounters; i++)
+  {
+    dst->counterTotals[i] += src->counterTotals[i];
+  }
+  dst->nbCountedIterations += src->nbCountedIterations;
+  dst->countersMask |= src->countersMask;
+  for (const auto& c : src->children)
+  {
+    if (c.second->isStale())
+    {
+      continue;
+    }
+    Benchmark*& child = dst->children[c.first];
+    if (child == NULL)
+    {
+      child = new Benchmark(dst, c.first);
+    }
+    merge(child, c.second);
+  }
+}
+
+Benchmark::ThreadRecord& Benchmark::getThreadRecord()
+{
+  if (!threadRecord)
+  {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    threadRecord = std::make_shared<ThreadRecord>(registry.size());
+    threadRecord->tree.reset(new Benchmark(NULL, "thread_" + std::to_string(registry.size())));
+    // The registry keeps the record alive after the thread exits
+    registry.push_back(threadRecord);
+  }
+  return *threadRecord;
+}
+
+std::vector<std::shared_ptr<Benchmark::ThreadRecord>> Benchmark::getRecords()
+{
+  std::lock_guard<std::mutex> registryLock(registryMutex);
+  return registry;
+}
+
+void Benchmark::publish(const Benchmark* root)
+{
+  ThreadRecord& record = getThreadRecord();
+  // Readers cannot take the pending tree while it is merged into
+  Benchmark* tree = record.pending.exchange(NULL, std::memory_order_acquire);
+  if (tree == NULL)
+  {
+    tree = new Benchmark(NULL, "pending");
+  }
+  // The pending tree holds the roots as children
+  Benchmark*& child = tree->children[root->name];
+  if (child == NULL)
+  {
+    child = new Benchmark(tree, root->name);
+  }
+  merge(child, root);
+  tree->elapsedTicks += root->elapsedTicks;
+  tree->nbIterations++;
+  record.pending.store(tree, std::memory_order_release);
+}
+
+void Benchmark::takePending(ThreadRecord& record)
+{
+  std::unique_ptr<Benchmark> pending(record.pending.exchange(NULL, std::memory_order_acquire));
+  if (pending)
+  {
+    merge(record.tree.get(), pending.get());
+  }
+}
+
+const Benchmark* Benchmark::find(const Benchmark* root, const std::string& path)
+{
+  const Benchmark* node = root;
+  std::istringstream iss(path);
+  std::string childName;
+  while (node != NULL && std::getline(iss, childName, '/'))
+  {
+    auto it = node->children.find(childName);
+    node = it == node->children.end() ? NULL : it->second;
+  }
+  return node;
+}
+
+Benchmark* Benchmark::collect(const std::string& threadName)
+{
+  Benchmark* result = new Benchmark(NULL, threadName == "" ? "All threads" : threadName);
+  for (const auto& record : getRecords())
+  {
+    std::lock_guard<std::mutex> lock(record->mutex);
+    takePending(*record);
+    if (threadName == "" || record->tree->name == threadName)
+    {
+      merge(result, record->tree.get());
+    }
+  }
+  return result;
+}
+
+void Benchmark::setThreadName(const std::string& threadName)
+{
+  ThreadRecord& record = getThreadRecord();
+  std::lock_guard<std::mutex> lock(record.mutex);
+  record.tree->name = threadName;
+}
+
+std::vector<std::string> Benchmark::getThreadNames()
+{
+  std::vector<std::string> names;
+  std::lock_guard<std::mutex> registryLock(registryMutex);
+  for (const auto& record : registry)
+  {
+    std::lock_guard<std::mutex> lock(record->mutex);
+    names.push_back(record->tree->name);
+  }
+  return names;
+}
+
+void Benchmark::printMerged(std::ostream& out, int detailLevel)
+{
+  std::unique_ptr<Benchmark> tree(collect());
+  tree->print(out, detailLevel);
+}
+
+void Benchmark::printThreads(std::ostream& out, int detailLevel)
+{
+  for (const auto& record : getRecords())
+  {
+    // Print a copy, so that a slow stream does not block other readers
+    std::unique_ptr<Benchmark> tree;
+    {
+      std::lock_guard<std::mutex> lock(record->mutex);
+      takePending(*record);
+      tree.reset(new Benchmark(NULL, record->tree->name));
+      merge(tree.get(), record->tree.get());
+    }
+    tree->print(out, detailLevel);
+  }
+}
+
+void Benchmark::printMergedCSV(std::ostream& out, bool header, int detailLevel)
+{
+  std::unique_ptr<Benchmark> tree(collect());
+  if (header)
+    printCSVHeader(out);
+  tree->printCSV(out, 0, detailLevel);
+}
+
+bool Benchmark::getStats(const std::string& path, double* time, int* nbIterations, const std::string& threadName)
+{
+  std::unique_ptr<Benchmark> tree(collect(threadName));
+  const Benchmark* node = find(tree.get(), path);
+  if (node == NULL)
+  {
+    return false;
+  }
+  if (time != NULL)
+    *time = node->getTime();
+  if (nbIterations != NULL)
+    *nbIterations = node->nbIterations;
+  return true;
+}
+
+void Benchmark::clearRegistry()
+{
+  std::lock_guard<std::mutex> registryLock(registryMutex);
+  for (const auto& record : registry)
+  {
+    std::lock_guard<std::mutex> lock(record->mutex);
+    std::string threadName = record->tree->name;
+    record->tree.reset(new Benchmark(NULL, threadName));
+    delete record->pending.exchange(NULL, std::memory_order_acquire);
+  }
+}
+
+void Benchmark::trace(Benchmark* b, char phase, uint64_t ticks)
+{
+  if (!tracing.load(std::memory_order_relaxed))
+  {
+    return;
+  }
+  ThreadRecord& record = getThreadRecord();
+  uint64_t generation = traceGeneration.load(std::memory_order_acquire);
+  if (record.traceGeneration != generation)
+  {
+    // First event of this thread since tracing started
+    std::lock_guard<std::mutex> lock(record.mutex);
+    std::vector<ThreadRecord::TraceEvent>(traceCapacity.load()).swap(record.events);
+    record.nbEvents = 0;
+    record.nbDropped = 0;
+    record.traceGeneration = generation;
+  }
+  const std::string* name = getInternedName(b);
+  size_t index = record.nbEvents.load(std::memory_order_relaxed);
+  if (index >= record.events.size())
+  {
+    record.nbDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  record.events[index] = ThreadRecord::TraceEvent{ name, ticks, phase };
+  record.nbEvents.store(index + 1, std::memory_order_release);
+}
+
+const std::string* Benchmark::getInternedName(Benchmark* b)
+{
+  if (b->internedName == NULL)
+  {
+    // The thread local cache avoids locking for known names
+    thread_local std::unordered_map<std::string, const std::string*> cache;
+    const std::string*& name = cache[b->name];
+    if (name == NULL)
+    {
+      name = intern(b->name);
+    }
+    b->internedName = name;
+  }
+  return b->internedName;
+}
+
+void Benchmark::startTracing(size_t nbEventsPerThread)
+{
+  // Threads reset their buffer at their first event of the new
+  // generation, events of older generations are not exported
+  traceCapacity = nbEventsPerThread;
+  traceGeneration++;
+  tracing = true;
+}
+
+void Benchmark::stopTracing()
+{
+  tracing = false;
+}
+
+bool Benchmark::isTracing()
+{
+  return tracing;
+}
+
+uint64_t Benchmark::getNbDroppedEvents()
+{
+  uint64_t nbDropped = 0;
+  std::lock_guard<std::mutex> registryLock(registryMutex);
+  for (const auto& record : registry)
+  {
+    std::lock_guard<std::mutex> lock(record->mutex);
+    if (record->traceGeneration == traceGeneration)
+    {
+      nbDropped += record->nbDropped;
+    }
+  }
+  return nbDropped;
+}
+
+/**
+ * Write str as a JSON string
+ */
+static void writeJSONString(std::ostream& out, const std::string& str)
+{
+  out << '"';
+  for (char c : str)
+  {
+    if (c == '"' || c == '\\')
+    {
+      out << '\\' << c;
+    }
+    else if ((unsigned char)c < 0x20)
+    {
+      out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+    }
+    else
+    {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+void Benchmark::writeTrace(std::ostream& out)
+{
+  int pid = getpid();
+  std::ios::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+  out.setf(std::ios::fixed, std::ios::floatfield);
+  out.precision(3);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  std::lock_guard<std::mutex> registryLock(registryMutex);
+  for (const auto& record : registry)
+  {
+    std::lock_guard<std::mutex> lock(record->mutex);
+    // Thread name metadata
+    out << (first ? "" : ",") << std::endl
+        << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << record->index
+        << ",\"args\":{\"name\":";
+    writeJSONString(out, record->tree->name);
+    out << "}}";
+    first = false;
+    size_t nbEvents = 0;
+    if (record->traceGeneration == traceGeneration)
+    {
+      nbEvents = record->nbEvents.load(std::memory_order_acquire);
+    }
+    for (size_t i = 0; i < nbEvents; i++)
+    {
+      const ThreadRecord::TraceEvent& event = record->events[i];
+      double us = duration<double, std::micro>(TimeStamp::fromTicks(event.ticks).time_since_epoch()).count();
+      out << "," << std::endl << "{\"name\":";
+      writeJSONString(out, *event.name);
+      out << ",\"ph\":\"" << event.phase << "\",\"ts\":" << us << ",\"pid\":" << pid << ",\"tid\":" << record->index
+          << "}";
+    }
+  }
+  out << std::endl << "]}" << std::endl;
+  out.flags(flags);
+  out.precision(precision);
+}
+
+void Benchmark::writeTrace(const std::string& path)
+{
+  std::ofstream out(path);
+  if (!out)
+  {
+    throw std::runtime_error(DEBUG_INFO + " failed to open '" + path + "'");
+  }
+  writeTrace(out);
+}
+
+void Benchmark::enableCounters(bool enable)
+{
+  counting = enable;
+}
+
+bool Benchmark::areCountersEnabled()
+{
+  return counting;
+}
+
+bool Benchmark::hasCounters()
+{
+  return getThreadCounters() != NULL;
+}
+
+bool Benchmark::readCounters(PerfCounters::Values* values, uint32_t* mask)
+{
+  PerfCounters* counters = counting.load(std::memory_order_relaxed) ? getThreadCounters() : NULL;
+  if (counters == NULL)
+  {
+    return false;
+  }
+  counters->read(*values);
+  if (mask != NULL)
+    *mask = counters->getAvailableMask();
+  return true;
+}
+
+bool Benchmark::getCounterStats(const std::string& path, std::array<double, PerfCounters::NbCounters>* perIteration,
+                                const std::string& threadName)
+{
+  std::unique_ptr<Benchmark> tree(collect(threadName));
+  const Benchmark* node = find(tree.get(), path);
+  if (node == NULL || node->nbCountedIterations == 0)
+  {
+    return false;
+  }
+  if (perIteration != NULL)
+  {
+    for (int i = 0; i < PerfCounters::NbCounters; i++)
+    {
+      (*perIteration)[i] = node->getCounterPerIteration(PerfCounters::Counter(i));
+    }
+  }
+  return true;
+}
+
+void Benchmark::snapshot(uint64_t ticks, bool force)
+{
+  ThreadRecord& record = getThreadRecord();
+  uint64_t generation = snapshotGeneration.load(std::memory_order_acquire);
+  if (record.snapshotGeneration != generation)
+  {
+    // First check of this thread since snapshots started
+    {
+      std::lock_guard<std::mutex> lock(record.snapshotMutex);
+      std::vector<ThreadRecord::SnapshotSlot>(snapshotNbSlots.load()).swap(record.snapshots);
+      for (ThreadRecord::SnapshotSlot& slot : record.snapshots)
+      {
+        slot.entries.resize(snapshotCapacity.load());
+      }
+      record.snapshotHead = 0;
+      record.snapshotTail = 0;
+      record.nbDelayedSnapshots = 0;
+      record.snapshotGeneration = generation;
+    }
+    // Only measure from now on
+    std::vector<SnapshotEntry> none;
+    size_t nbEntries = 0;
+    size_t nbTruncated = 0;
+    for (auto& root : getArena().roots)
+    {
+      fillSnapshot(root.second, 0, none, &nbEntries, &nbTruncated);
+    }
+    record.lastSnapshotTicks = ticks;
+    record.nextSnapshotTicks = ticks + snapshotPeriod.load();
+    return;
+  }
+  if (!force && ticks < record.nextSnapshotTicks)
+  {
+    return;
+  }
+  record.nextSnapshotTicks = ticks + snapshotPeriod.load(std::memory_order_relaxed);
+  uint64_t head = record.snapshotHead.load(std::memory_order_relaxed);
+  if (head - record.snapshotTail.load(std::memory_order_acquire) >= record.snapshots.size())
+  {
+    // Times keep accumulating until a slot is available
+    record.nbDelayedSnapshots.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  ThreadRecord::SnapshotSlot& slot = record.snapshots[head % record.snapshots.size()];
+  slot.startTicks = record.lastSnapshotTicks;
+  slot.endTicks = ticks;
+  slot.nbEntries = 0;
+  slot.nbTruncated = 0;
+  for (auto& root : getArena().roots)
+  {
+    fillSnapshot(root.second, 0, slot.entries, &slot.nbEntries, &slot.nbTruncated);
+  }
+  record.snapshotHead.store(head + 1, std::memory_order_release);
+  record.lastSnapshotTicks = ticks;
+}
+
+void Benchmark::fillSnapshot(Benchmark* node, int depth, std::vector<SnapshotEntry>& entries, size_t* nbEntries,
+                             size_t* nbTruncated)
+{
+  if (node->snapshotIterations > 0)
+  {
+    if (*nbEntries < entries.size())
+    {
+      const std::string* fatherName = node->father == NULL ? NULL : getInternedName(node->father);
+      entries[*nbEntries] =
+          SnapshotEntry{ getInternedName(node), fatherName, depth, node->snapshotTicks, node->snapshotIterations };
+      (*nbEntries)++;
+    }
+    else
+    {
+      (*nbTruncated)++;
+    }
+    node->snapshotTicks = 0;
+    node->snapshotIterations = 0;
+  }
+  for (auto& c : node->children)
+  {
+    fillSnapshot(c.second, depth + 1, entries, nbEntries, nbTruncated);
+  }
+}
+
+void Benchmark::startSnapshots(double period, size_t nbEntries, size_t nbSlots)
+{
+  if (period <= 0 || nbSlots == 0)
+  {
+    throw std::runtime_error(DEBUG_INFO + " invalid snapshot period " + std::to_string(period) + " or number of slots " +
+                             std::to_string(nbSlots));
+  }
+  // Threads reset their ring at their first check of the new generation
+  snapshotPeriod = uint64_t(period * TscClock::getFrequency());
+  snapshotCapacity = nbEntries;
+  snapshotNbSlots = nbSlots;
+  snapshotGeneration++;
+  snapshotting = true;
+}
+
+void Benchmark::stopSnapshots()
+{
+  snapshotting = false;
+}
+
+bool Benchmark::isSnapshotting()
+{
+  return snapshotting;
+}
+
+void Benchmark::publishSnapshot()
+{
+  if (snapshotGeneration == 0)
+  {
+    return;
+  }
+  snapshot(TscClock::now(), true);
+}
+
+size_t Benchmark::popSnapshots(std::vector<Snapshot>* snapshots)
+{
+  size_t nbPopped = 0;
+  for (const auto& record : getRecords())
+  {
+    std::string threadName;
+    {
+      std::lock_guard<std::mutex> lock(record->mutex);
+      threadName = record->tree->name;
+    }
+    std::lock_guard<std::mutex> lock(record->snapshotMutex);
+    if (record->snapshotGeneration != snapshotGeneration)
+    {
+      continue;
+    }
+    uint64_t head = record->snapshotHead.load(std::memory_order_acquire);
+    for (uint64_t tail = record->snapshotTail.load(std::memory_order_relaxed); tail < head; tail++)
+    {
+      const ThreadRecord::SnapshotSlot& slot = record->snapshots[tail % record->snapshots.size()];
+      Snapshot snapshot;
+      snapshot.threadName = threadName;
+      snapshot.startTicks = slot.startTicks;
+      snapshot.endTicks = slot.endTicks;
+      snapshot.nbTruncated = slot.nbTruncated;
+      snapshot.entries.assign(slot.entries.begin(), slot.entries.begin() + slot.nbEntries);
+      snapshots->push_back(snapshot);
+      nbPopped++;
+    }
+    record->snapshotTail.store(head, std::memory_order_release);
+  }
+  return nbPopped;
+}
+
+uint64_t Benchmark::getNbDelayedSnapshots()
+{
+  uint64_t nbDelayed = 0;
+  std::lock_guard<std::mutex> registryLock(registryMutex);
+  for (const auto& record : registry)
+  {
+    std::lock_guard<std::mutex> lock(record->snapshotMutex);
+    if (record->snapshotGeneration == snapshotGeneration)
+    {
+      nbDelayed += record->nbDelayedSnapshots;
+    }
   }
+  return nbDelayed;
 }
 }  // namespace starkit_utils
@@ -0,0 +1,119 @@
+#include "starkit_utils/timing/benchmark_snapshot_writer.h"
+
+#include "starkit_utils/sockets/udp_broadcast.h"
+#include "starkit_utils/util.h"
+
+#include <chrono>
+#include <sstream>
+
+namespace starkit_utils
+{
+BenchmarkSnapshotWriter::BenchmarkSnapshotWriter(std::ostream& out, double pollPeriod)
+  : out(&out), pollPeriod(pollPeriod), nbWritten(0), stopped(false)
+{
+  printCSVHeader(out);
+  start();
+}
+
+BenchmarkSnapshotWriter::BenchmarkSnapshotWriter(const std::string& path, double pollPeriod)
+  : out(NULL), file(new std::ofstream(path)), pollPeriod(pollPeriod), nbWritten(0), stopped(false)
+{
+  if (!*file)
+  {
+    throw std::runtime_error(DEBUG_INFO + " failed to open '" + path + "'");
+  }
+  out = file.get();
+  printCSVHeader(*out);
+  start();
+}
+
+BenchmarkSnapshotWriter::BenchmarkSnapshotWriter(int port, double pollPeriod)
+  : out(NULL), udp(new UDPBroadcast(-1, port)), pollPeriod(pollPeriod), nbWritten(0), stopped(false)
+{
+  start();
+}
+
+BenchmarkSnapshotWriter::~BenchmarkSnapshotWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+  }
+  condition.notify_all();
+  thread.join();
+}
+
+size_t BenchmarkSnapshotWriter::getNbWritten() const
+{
+  return nbWritten;
+}
+
+void BenchmarkSnapshotWriter::start()
+{
+  thread = std::thread(&BenchmarkSnapshotWriter::run, this);
+}
+
+void BenchmarkSnapshotWriter::run()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!stopped)
+  {
+    condition.wait_for(lock, std::chrono::duration<double>(pollPeriod));
+    write();
+  }
+}
+
+void BenchmarkSnapshotWriter::write()
+{
+  snapshots.clear();
+  Benchmark::popSnapshots(&snapshots);
+  for (const Benchmark::Snapshot& snapshot : snapshots)
+  {
+    if (udp)
+    {
+      std::ostringstream message;
+      printCSVHeader(message);
+      printCSV(message, snapshot);
+      std::string str = message.str();
+      udp->broadcastMessage((const unsigned char*)str.data(), str.size());
+    }
+    else
+    {
+      printCSV(*out, snapshot);
+    }
+  }
+  if (out != NULL)
+  {
+    out->flush();
+  }
+  nbWritten += snapshots.size();
+}
+
+void BenchmarkSnapshotWriter::printCSVHeader(std::ostream& out)
+{
+  out << "timestamp,period,thread,depth,name,father,time,iterations" << std::endl;
+}
+
+void BenchmarkSnapshotWriter::printCSV(std::ostream& out, const Benchmark::Snapshot& snapshot)
+{
+  std::ios::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+  out.setf(std::ios::fixed, std::ios::floatfield);
+  out.precision(6);
+  double timestamp = TimeStamp::fromTicks(snapshot.endTicks).getTimeSec();
+  double period = TscClock::toSeconds(snapshot.endTicks - snapshot.startTicks);
+  for (const Benchmark::SnapshotEntry& entry : snapshot.entries)
+  {
+    out << timestamp << "," << period << "," << snapshot.threadName << "," << entry.depth << "," << *entry.name << ","
+        << (entry.fatherName == NULL ? "unknown" : *entry.fatherName) << "," << TscClock::toSeconds(entry.ticks)
+        << "," << entry.nbIterations << std::endl;
+  }
+  if (snapshot.nbTruncated > 0)
+  {
+    out << timestamp << "," << period << "," << snapshot.threadName << ",0,truncated,unknown,,"
+        << snapshot.nbTruncated << std::endl;
+  }
+  out.flags(flags);
+  out.precision(precision);
+}
+}  // namespace starkit_utils
@@ -1,9 +1,34 @@
 #include "starkit_utils/timing/elapse_tick.h"
 
+#include <algorithm>
+
 namespace starkit_utils
 {
-ElapseTick::ElapseTick() : hasStats(false), minTime(0.0), avgTime(0.0), maxTime(0.0), lastTimestamp(TimeStamp::now())
+/**
+ * Duration between two time stamps [ns]
+ */
+static uint64_t diffNs(const TimeStamp& src, const TimeStamp& dst)
 {
+  int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(dst - src).count();
+  return ns < 0 ? 0 : ns;
+}
+
+ElapseTick::ElapseTick()
+  : hasStats(false)
+  , minTime(0.0)
+  , avgTime(0.0)
+  , maxTime(0.0)
+  , nbMisses(0)
+  , missStreak(0)
+  , longestMissStreak(0)
+  , lastTimestamp(TimeStamp::now())
+  , hasTicked(false)
+  , deadline(0)
+{
+  // Ticks never allocate
+  times.reserve();
+  periods.reserve();
+  lastTimestamp = TimeStamp::now();
 }
 
 ElapseTick::~ElapseTick()
@@ -14,6 +39,11 @@ void ElapseTick::tick()
 {
   TimeStamp nowT = TimeStamp::now();
   double elapsed = diffSec(lastTimestamp, nowT);
+  if (hasTicked)
+  {
+    periods.record(diffNs(lastTimestamp, nowT));
+  }
+  hasTicked = true;
   lastTimestamp = nowT;
 
   // Call tick implementation
@@ -40,7 +70,82 @@ void ElapseTick::tick()
         maxTime = duration;
       avgTime = avgTime * 0.99 + duration * 0.01;
     }
+    uint64_t durationNs = diffNs(start, stop);
+    times.record(durationNs);
+    if (deadline > 0)
+    {
+      if (durationNs > deadline)
+      {
+        nbMisses++;
+        missStreak++;
+        longestMissStreak = std::max(longestMissStreak, missStreak);
+        lastMiss = stop;
+      }
+      else
+      {
+        missStreak = 0;
+      }
+    }
+  }
+}
+
+void ElapseTick::setDeadline(double deadlineMs)
+{
+  deadline = deadlineMs > 0 ? uint64_t(deadlineMs * 1e6) : 0;
+  missStreak = 0;
+}
+
+double ElapseTick::getDeadline() const
+{
+  return deadline / 1e6;
+}
+
+double ElapseTick::getTimePercentile(double ratio) const
+{
+  return times.percentile(ratio) / 1e6;
+}
+
+double ElapseTick::getPeriodPercentile(double ratio) const
+{
+  return periods.percentile(ratio) / 1e6;
+}
+
+const LatencyHistogram& ElapseTick::getTimes() const
+{
+  return times;
+}
+
+const LatencyHistogram& ElapseTick::getPeriods() const
+{
+  return periods;
+}
+
+void ElapseTick::resetStats()
+{
+  hasStats = false;
+  minTime = 0.0;
+  avgTime = 0.0;
+  maxTime = 0.0;
+  nbMisses = 0;
+  missStreak = 0;
+  longestMissStreak = 0;
+  lastMiss = TimeStamp();
+  times.clear();
+  periods.clear();
+}
+
+void ElapseTick::printStats(std::ostream& out) const
+{
+  out << "time p50 " << getTimePercentile(0.5) << " ms, p99 " << getTimePercentile(0.99) << " ms, p99.9 "
+      << getTimePercentile(0.999) << " ms, max " << maxTime << " ms; period p50 " << getPeriodPercentile(0.5)
+      << " ms, p99 " << getPeriodPercentile(0.99) << " ms, p99.9 " << getPeriodPercentile(0.999) << " ms, max "
+      << periods.max() / 1e6 << " ms";
+  if (deadline > 0)
+  {
+    out << "; " << nbMisses << " misses of " << getDeadline() << " ms deadline, longest streak "
+        << longestMissStreak;
   }
+  out << std::endl;
 }
 
 }  // namespace starkit_utils
@@ -0,0 +1,139 @@
+#include "starkit_utils/timing/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace starkit_utils
+{
+constexpr int LatencyHistogram::SubBuckets;
+constexpr size_t LatencyHistogram::NbBuckets;
+
+LatencyHistogram::LatencyHistogram() : _count(0), _min(std::numeric_limits<uint64_t>::max()), _max(0)
+{
+}
+
+LatencyHistogram::LatencyHistogram(const LatencyHistogram& other) : LatencyHistogram()
+{
+  *this = other;
+}
+
+LatencyHistogram& LatencyHistogram::operator=(const LatencyHistogram& other)
+{
+  if (this != &other)
+  {
+    clear();
+    merge(other);
+  }
+  return *this;
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t value)
+{
+  if (value < SubBuckets)
+  {
+    return value;
+  }
+  // Position of the most significant bit, at least 4
+  int msb = 63 - __builtin_clzll(value);
+  int shift = msb - 4;
+  return (msb - 3) * SubBuckets + ((value >> shift) & (SubBuckets - 1));
+}
+
+uint64_t LatencyHistogram::bucketLowest(size_t index)
+{
+  if (index < SubBuckets)
+  {
+    return index;
+  }
+  int msb = index / SubBuckets + 3;
+  uint64_t sub = index % SubBuckets;
+  return (SubBuckets + sub) << (msb - 4);
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+  reserve();
+  _buckets[bucketIndex(value)]++;
+  _count++;
+  _min = std::min(_min, value);
+  _max = std::max(_max, value);
+}
+
+void LatencyHistogram::reserve()
+{
+  if (!_buckets)
+  {
+    _buckets.reset(new uint64_t[NbBuckets]());
+  }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+  if (other._count == 0)
+  {
+    return;
+  }
+  reserve();
+  // As in clear(), only buckets between min and max may be used
+  size_t last = bucketIndex(other._max);
+  for (size_t i = bucketIndex(other._min); i <= last; i++)
+  {
+    _buckets[i] += other._buckets[i];
+  }
+  _count += other._count;
+  _min = std::min(_min, other._min);
+  _max = std::max(_max, other._max);
+}
+
+void LatencyHistogram::clear()
+{
+  if (_buckets && _count > 0)
+  {
+    // Only buckets between min and max may be used
+    std::fill(_buckets.get() + bucketIndex(_min), _buckets.get() + bucketIndex(_max) + 1, 0);
+  }
+  _count = 0;
+  _min = std::numeric_limits<uint64_t>::max();
+  _max = 0;
+}
+
+uint64_t LatencyHistogram::count() const
+{
+  return _count;
+}
+
+uint64_t LatencyHistogram::min() const
+{
+  return _count == 0 ? 0 : _min;
+}
+
+uint64_t LatencyHistogram::max() const
+{
+  return _max;
+}
+
+double LatencyHistogram::percentile(double ratio) const
+{
+  if (_count == 0)
+  {
+    return 0;
+  }
+  // Rank of the value, from 1 to _count
+  uint64_t rank = std::max<uint64_t>(1, std::ceil(ratio * _count));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NbBuckets; i++)
+  {
+    seen += _buckets[i];
+    if (seen >= rank)
+    {
+      double lowest = bucketLowest(i);
+      double width = i + 1 < NbBuckets ? bucketLowest(i + 1) - lowest : lowest;
+      double value = lowest + (width - 1) / 2;
+      return std::min<double>(std::max<double>(value, _min), _max);
+    }
+  }
+  return _max;
+}
+
+}  // namespace starkit_utils
@@ -0,0 +1,147 @@
+#include "starkit_utils/timing/perf_counters.h"
+
+#include "starkit_utils/util.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace starkit_utils
+{
+#ifdef __linux__
+/**
+ * Open a counter of the calling thread in the group of leader (-1 to
+ * create a group), return -1 on failure
+ */
+static int openCounter(uint32_t type, uint64_t config, bool excludeKernel, int leader)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = excludeKernel;
+  attr.exclude_hv = 1;
+  return syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+}
+#endif
+
+PerfCounters::PerfCounters() : _leader(-1), _nbOpened(0)
+{
+  _fds.fill(-1);
+  _order.fill(-1);
+#ifdef __linux__
+  const uint32_t types[NbCounters] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                       PERF_TYPE_SOFTWARE };
+  const uint64_t configs[NbCounters] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                         PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+                                         PERF_COUNT_SW_CONTEXT_SWITCHES };
+  for (int counter = 0; counter < NbCounters; counter++)
+  {
+    // Context switches happen in the kernel, only count user space
+    // events if not allowed to count kernel ones
+    bool kernel = counter == ContextSwitches;
+    int fd = openCounter(types[counter], configs[counter], !kernel, _leader);
+    if (fd < 0 && kernel)
+    {
+      fd = openCounter(types[counter], configs[counter], true, _leader);
+    }
+    if (fd < 0)
+    {
+      continue;
+    }
+    if (_leader < 0)
+    {
+      _leader = fd;
+    }
+    _fds[counter] = fd;
+    _order[_nbOpened] = counter;
+    _nbOpened++;
+  }
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+  for (int fd : _fds)
+  {
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+  }
+#endif
+}
+
+bool PerfCounters::isAvailable() const
+{
+  return _leader >= 0;
+}
+
+bool PerfCounters::isAvailable(Counter counter) const
+{
+  return _fds[counter] >= 0;
+}
+
+uint32_t PerfCounters::getAvailableMask() const
+{
+  uint32_t mask = 0;
+  for (int counter = 0; counter < NbCounters; counter++)
+  {
+    if (_fds[counter] >= 0)
+    {
+      mask |= 1 << counter;
+    }
+  }
+  return mask;
+}
+
+void PerfCounters::read(Values& values) const
+{
+  values.fill(0);
+#ifdef __linux__
+  if (_leader < 0)
+  {
+    return;
+  }
+  // Group read format: number of values followed by the values
+  uint64_t buffer[1 + NbCounters];
+  ssize_t size = ::read(_leader, buffer, sizeof(buffer));
+  if (size < ssize_t(sizeof(uint64_t)))
+  {
+    return;
+  }
+  for (uint64_t i = 0; i < buffer[0] && int(i) < _nbOpened; i++)
+  {
+    values[_order[i]] = buffer[1 + i];
+  }
+#endif
+}
+
+std::string PerfCounters::getName(Counter counter)
+{
+  switch (counter)
+  {
+    case Cycles:
+      return "cycles";
+    case Instructions:
+      return "instructions";
+    case LLCMisses:
+      return "llc_misses";
+    case BranchMisses:
+      return "branch_misses";
+    case ContextSwitches:
+      return "context_switches";
+    default:
+      throw std::out_of_range(DEBUG_INFO + " invalid counter " + std::to_string(counter));
+  }
+}
+
+}  // namespace starkit_utils
@@ -1,4 +1,5 @@
 #include "starkit_utils/timing/time_stamp.h"
+#include "starkit_utils/timing/tsc_clock.h"
 
 #include <ctime>
 
@@ -23,6 +24,11 @@ TimeStamp TimeStamp::fromMS(unsigned long msSinceEpoch)
   return TimeStamp(time_point<steady_clock>(milliseconds(msSinceEpoch)));
 }
 
+TimeStamp TimeStamp::fromTicks(uint64_t ticks)
+{
+  return TimeStamp(TscClock::toSteady(ticks));
+}
+
 double TimeStamp::getTimeSec() const
 {
   return getTimeMS() / 1000;
@@ -0,0 +1,93 @@
+#include "starkit_utils/timing/tsc_clock.h"
+
+#if STARKIT_UTILS_HAS_RDTSC
+#include <cpuid.h>
+#endif
+
+using namespace std::chrono;
+
+namespace starkit_utils
+{
+constexpr double TscClock::CalibrationDuration;
+
+/**
+ * Calibration reference, taken at the first read
+ */
+static uint64_t referenceTicks = 0;
+static steady_clock::time_point referenceTime;
+
+/**
+ * Take the reference when the library is loaded, so that the
+ * calibration is usually over at the first conversion
+ */
+static const bool startupTsc = TscClock::usesTsc();
+
+bool TscClock::hasInvariantTsc()
+{
+#if STARKIT_UTILS_HAS_RDTSC
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007)
+  {
+    return false;
+  }
+  __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+  // Advanced power management: invariant TSC
+  return (edx & (1 << 8)) != 0;
+#else
+  return false;
+#endif
+}
+
+bool TscClock::initialize()
+{
+  bool tsc = hasInvariantTsc();
+  referenceTime = steady_clock::now();
+#if STARKIT_UTILS_HAS_RDTSC
+  referenceTicks = tsc ? __rdtsc() : referenceTime.time_since_epoch().count();
+#else
+  referenceTicks = referenceTime.time_since_epoch().count();
+#endif
+  return tsc;
+}
+
+/**
+ * Measure the TSC frequency from the reference, waiting until
+ * the calibration duration elapsed
+ */
+static double calibrate()
+{
+  if (!TscClock::usesTsc())
+  {
+    return double(steady_clock::period::den) / steady_clock::period::num;
+  }
+  steady_clock::time_point time;
+  uint64_t ticks;
+  do
+  {
+    time = steady_clock::now();
+    ticks = TscClock::now();
+  } while (duration<double>(time - referenceTime).count() < TscClock::CalibrationDuration);
+  return (ticks - referenceTicks) / duration<double>(time - referenceTime).count();
+}
+
+double TscClock::getFrequency()
+{
+  // Makes sure the reference is taken
+  usesTsc();
+  static const double frequency = calibrate();
+  return frequency;
+}
+
+double TscClock::toSeconds(double ticks)
+{
+  return ticks / getFrequency();
+}
+
+steady_clock::time_point TscClock::toSteady(uint64_t ticks)
+{
+  double frequency = getFrequency();
+  double seconds = (int64_t(ticks - referenceTicks)) / frequency;
+  return referenceTime + duration_cast<steady_clock::duration>(duration<double>(seconds));
+}
+
+}  // namespace starkit_utils
@@ -1,5 +1,12 @@
 #include <gtest/gtest.h>
 #include <starkit_utils/history/history.h>
+#include <starkit_utils/angle.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 
 using namespace starkit_utils;
 
@@ -206,6 +213,315 @@ TEST(history, binary)
   EXPECT_DOUBLE_EQ(h2.back().second, 4.);
 }
 
+// Empty or truncated binary logs are loaded as an empty History.
+TEST(history, binaryEmpty)
+{
+  History h;
+  std::istringstream empty{ "" };
+  h.loadReplay(empty, true);
+  EXPECT_EQ(0, h.size());
+
+  std::istringstream truncated{ std::string("\x01\x02\x03", 3) };
+  h.loadReplay(truncated, true);
+  EXPECT_EQ(0, h.size());
+}
+
+// Only the complete points of a binary log with a truncated body are loaded.
+TEST(history, binaryTruncatedBody)
+{
+  History h;
+  h.startLogging();
+  for (int i = 0; i < 5; i++)
+  {
+    h.pushValue(i, 2. * i);
+  }
+  std::ostringstream os;
+  h.stopLogging(os, true);
+  std::string log = os.str();
+  // Cut the last value in the middle
+  std::istringstream truncated{ log.substr(0, log.size() - 4) };
+  History replay;
+  replay.loadReplay(truncated, true);
+  EXPECT_EQ(4, replay.size());
+  EXPECT_DOUBLE_EQ(3., replay.back().first);
+  EXPECT_DOUBLE_EQ(6., replay.back().second);
+
+  // The declared size is much larger than the body
+  size_t size = 1000000000;
+  std::string header((const char*)&size, sizeof(size_t));
+  std::istringstream huge{ header + log.substr(sizeof(size_t)) };
+  replay.loadReplay(huge, true);
+  EXPECT_EQ(5, replay.size());
+}
+
+// Check that loading a time range of binary and compressed logs gives the
+// points covering the range.
+TEST(history, loadReplayRange)
+{
+  History h1(1000.);
+  h1.startLogging();
+  for (int i = 0; i < 10000; i++)
+  {
+    h1.pushValue(i * 0.01, i);
+  }
+  for (History::LogFormat format : { History::Binary, History::Compressed })
+  {
+    History copy(1000.);
+    std::ostringstream log;
+    copy.startLogging();
+    for (const auto& point : h1.getValues())
+    {
+      copy.pushValue(point.first, point.second);
+    }
+    copy.stopLogging(log, format);
+
+    History h2;
+    std::istringstream is{ log.str() };
+    h2.loadReplayRange(is, 52.005, 54.0, 10.);
+    EXPECT_EQ(201, h2.size());
+    EXPECT_DOUBLE_EQ(52., h2.front().first);
+    EXPECT_DOUBLE_EQ(4200., h2.front().second);
+    EXPECT_DOUBLE_EQ(54., h2.back().first);
+    EXPECT_DOUBLE_EQ(h1.interpolate(43.), h2.interpolate(53.));
+
+    // Ranges outside of the log keep the closest point
+    std::istringstream before{ log.str() };
+    h2.loadReplayRange(before, -5., -2.);
+    EXPECT_EQ(1, h2.size());
+    EXPECT_DOUBLE_EQ(0., h2.front().first);
+    std::istringstream after{ log.str() };
+    h2.loadReplayRange(after, 500., 600.);
+    EXPECT_EQ(1, h2.size());
+    EXPECT_DOUBLE_EQ(9999., h2.back().second);
+  }
+
+  // Truncated binary logs are read up to their last complete record, as loadReplay
+  History copy(1000.);
+  std::ostringstream log;
+  copy.startLogging();
+  for (const auto& point : h1.getValues())
+  {
+    copy.pushValue(point.first, point.second);
+  }
+  copy.stopLogging(log, History::Binary);
+  std::string truncatedLog = log.str().substr(0, log.str().size() - 4);
+  for (double tStart : { 52.005, 500. })
+  {
+    History range;
+    std::istringstream truncated{ truncatedLog };
+    range.loadReplayRange(truncated, tStart, tStart + 1000.);
+    History replay;
+    std::istringstream all{ truncatedLog };
+    replay.loadReplay(all, true);
+    EXPECT_DOUBLE_EQ(9998., range.back().second);
+    EXPECT_DOUBLE_EQ(replay.back().first, range.back().first);
+  }
+  History empty;
+  std::istringstream shortHeader{ std::string("\x01\x02\x03", 3) };
+  empty.loadReplayRange(shortHeader, 0., 1.);
+  EXPECT_EQ(0, empty.size());
+}
+
+// Check that the lock-free mode behaves as the default one.
+TEST(history, lockFreeBasic)
+{
+  History h(8., 16);
+  EXPECT_TRUE(h.isLockFree());
+  EXPECT_EQ(0, h.size());
+  EXPECT_DOUBLE_EQ(0., h.interpolate(1.));
+  h.pushValue(1., 2.);
+  h.pushValue(3., 4.);
+  h.pushValue(3., 5.);
+  h.pushValue(5., 12.);
+  EXPECT_EQ(3, h.size());
+  EXPECT_DOUBLE_EQ(1., h.front().first);
+  EXPECT_DOUBLE_EQ(12., h.back().second);
+  EXPECT_DOUBLE_EQ(2., h.interpolate(0.));
+  EXPECT_DOUBLE_EQ(3., h.interpolate(2.));
+  EXPECT_DOUBLE_EQ(8., h.interpolate(4.));
+  EXPECT_DOUBLE_EQ(12., h.interpolate(6.));
+  EXPECT_DOUBLE_EQ(-1.4247779607693793, h.interpolate(4., History::AngleRad));
+  ASSERT_THROW(h.pushValue(2., 33.), std::logic_error);
+  ASSERT_THROW(h.startLogging(), std::logic_error);
+}
+
+// Check that the lock-free mode drops values outside of the window or
+// exceeding the capacity.
+TEST(history, lockFreeWindow)
+{
+  History h(2., 4);
+  for (int i = 0; i < 10; i++)
+  {
+    h.pushValue(i, 10 * i);
+  }
+  EXPECT_EQ(3, h.size());
+  EXPECT_DOUBLE_EQ(7., h.front().first);
+  EXPECT_DOUBLE_EQ(75., h.interpolate(7.5));
+  h.setWindowSize(100.);
+  for (int i = 10; i < 20; i++)
+  {
+    h.pushValue(i, 10 * i);
+  }
+  EXPECT_EQ(4, h.size());
+  EXPECT_EQ(4, h.getValues().size());
+  h.clear();
+  EXPECT_EQ(0, h.size());
+}
+
+// Check that cursors and batches give the same results as interpolate,
+// for both increasing and random queries, while the window is moving.
+TEST(history, cursorAndBatch)
+{
+  for (bool lockFree : { false, true })
+  {
+    History h = lockFree ? History(5., 64) : History(5.);
+    History::Cursor cursor(h);
+    EXPECT_DOUBLE_EQ(0., cursor.interpolate(1.));
+    std::vector<double> queries;
+    for (int i = 0; i < 200; i++)
+    {
+      h.pushValue(i * 0.1, std::sin(i * 0.1));
+      // Increasing queries, including outside of the window
+      for (double dt : { -6., -0.35, -0.25, -0.01, 0., 0.05 })
+      {
+        double t = i * 0.1 + dt;
+        EXPECT_DOUBLE_EQ(h.interpolate(t), cursor.interpolate(t));
+        EXPECT_DOUBLE_EQ(h.interpolate(t, History::AngleRad), cursor.interpolate(t, History::AngleRad));
+      }
+    }
+    for (int i = 0; i < 100; i++)
+    {
+      queries.push_back(13. + i * 0.07);
+    }
+    queries.push_back(14.);
+    queries.push_back(0.);
+    std::vector<double> results(queries.size());
+    h.interpolateBatch(queries.data(), queries.size(), results.data());
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+      EXPECT_DOUBLE_EQ(h.interpolate(queries[i]), results[i]);
+    }
+    cursor.reset();
+    EXPECT_DOUBLE_EQ(h.interpolate(15.5), cursor.interpolate(15.5));
+    h.clear();
+    EXPECT_DOUBLE_EQ(0., cursor.interpolate(15.5));
+  }
+}
+
+// Check cubic kernels accuracy, monotonicity and angles unwrapping in both modes.
+TEST(history, interpolationKernels)
+{
+  for (bool lockFree : { false, true })
+  {
+    History h = lockFree ? History(10., 1024) : History(10.);
+    // Smooth signal sampled at 250 Hz
+    for (int i = 0; i <= 500; i++)
+    {
+      h.pushValue(i * 0.004, std::sin(10 * i * 0.004));
+    }
+    double linearError = 0.;
+    double cubicError = 0.;
+    History::Cursor cursor(h);
+    for (double t = 0.1; t < 1.9; t += 0.0013)
+    {
+      linearError = std::max(linearError, std::fabs(h.interpolate(t) - std::sin(10 * t)));
+      cubicError = std::max(cubicError, std::fabs(h.interpolate(t, History::CatmullRom) - std::sin(10 * t)));
+      EXPECT_DOUBLE_EQ(h.interpolate(t, History::CatmullRom), cursor.interpolate(t, History::CatmullRom));
+    }
+    EXPECT_LT(cubicError, linearError / 4);
+    EXPECT_DOUBLE_EQ(h.interpolate(1.0013), h.interpolate(1.0013, History::Linear));
+    EXPECT_DOUBLE_EQ(std::sin(10 * 0.4), h.interpolate(0.4, History::MonotoneCubic));
+    EXPECT_DOUBLE_EQ(0., h.interpolate(-1., History::CatmullRom));
+  }
+
+  // Step: Catmull-Rom overshoots, monotone cubic does not
+  History step(10.);
+  for (int i = 0; i < 10; i++)
+  {
+    step.pushValue(i, i < 5 ? 0. : 1.);
+  }
+  double minCatmullRom = 0.;
+  for (double t = 0.; t <= 9.; t += 0.01)
+  {
+    double value = step.interpolate(t, History::MonotoneCubic);
+    EXPECT_GE(value, 0.);
+    EXPECT_LE(value, 1.);
+    if (t > 4. && t < 5.)
+    {
+      EXPECT_LE(value, step.interpolate(t + 0.01, History::MonotoneCubic));
+    }
+    minCatmullRom = std::min(minCatmullRom, step.interpolate(t, History::CatmullRom));
+  }
+  EXPECT_LT(minCatmullRom, 0.);
+
+  // Angle crossing pi
+  History angle(10.);
+  for (int i = 0; i < 10; i++)
+  {
+    angle.pushValue(i, normalizeRad(3. + 0.1 * i));
+  }
+  for (History::Kernel kernel : { History::CatmullRom, History::MonotoneCubic })
+  {
+    for (double t = 1.; t <= 8.; t += 0.1)
+    {
+      EXPECT_NEAR(0., normalizeRad(angle.interpolate(t, kernel, History::AngleRad) - 3. - 0.1 * t), 1e-9);
+    }
+  }
+  EXPECT_THROW(angle.interpolate(1.5, History::Kernel(3)), std::logic_error);
+  EXPECT_THROW(angle.interpolate(1.5, History::CatmullRom, History::ValueType(2)), std::logic_error);
+}
+
+// Measure the push latency of a writer while readers keep interpolating.
+static std::vector<double> pushLatencies(History& h, int nbReaders, int nbPush)
+{
+  std::atomic<bool> running(true);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < nbReaders; i++)
+  {
+    readers.push_back(std::thread([&h, &running]() {
+      double sum = 0;
+      while (running)
+      {
+        sum += h.interpolate(h.back().first - 0.1);
+      }
+      EXPECT_TRUE(std::isfinite(sum));
+    }));
+  }
+  std::vector<double> latencies;
+  latencies.reserve(nbPush);
+  for (int i = 0; i < nbPush; i++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    h.pushValue(i * 0.001, i);
+    auto end = std::chrono::steady_clock::now();
+    latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+  }
+  running = false;
+  for (auto& reader : readers)
+  {
+    reader.join();
+  }
+  std::sort(latencies.begin(), latencies.end());
+  return latencies;
+}
+
+// Compare push latency tails of both modes under reader contention.
+TEST(history, contentionBenchmark)
+{
+  int nbPush = 200000;
+  History locked(2.);
+  History lockFree(2., 4096);
+  std::vector<double> lockedLatencies = pushLatencies(locked, 3, nbPush);
+  std::vector<double> lockFreeLatencies = pushLatencies(lockFree, 3, nbPush);
+  size_t p99 = nbPush * 99 / 100;
+  std::cout << "push p99 latency (us): mutex " << lockedLatencies[p99] << ", lock-free " << lockFreeLatencies[p99]
+            << std::endl;
+  std::cout << "push max latency (us): mutex " << lockedLatencies.back() << ", lock-free "
+            << lockFreeLatencies.back() << std::endl;
+  EXPECT_EQ(2001, locked.size());
+  EXPECT_EQ(2001, lockFree.size());
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
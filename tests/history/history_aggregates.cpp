@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <starkit_utils/history/history.h>
+#include <starkit_utils/stats/stats.h>
+
+#include <algorithm>
+#include <random>
+
+using namespace starkit_utils;
+
+// Check aggregates against a full recomputation over the window.
+TEST(historyAggregates, window)
+{
+  History h(0.5);
+  EXPECT_THROW(h.getAggregates(), std::logic_error);
+  h.enableAggregates();
+  HistoryAggregates::Summary summary = h.getAggregates();
+  EXPECT_EQ(0, summary.count);
+  EXPECT_DOUBLE_EQ(0., summary.variance);
+
+  std::mt19937 generator(42);
+  std::normal_distribution<double> noise(100., 3.);
+  for (int i = 0; i < 20000; i++)
+  {
+    h.pushValue(i * 0.01, noise(generator));
+    if (i % 97 == 0)
+    {
+      std::vector<double> values;
+      for (const auto& point : h.getValues())
+      {
+        values.push_back(point.second);
+      }
+      summary = h.getAggregates();
+      EXPECT_EQ(values.size(), summary.count);
+      EXPECT_DOUBLE_EQ(*std::min_element(values.begin(), values.end()), summary.min);
+      EXPECT_DOUBLE_EQ(*std::max_element(values.begin(), values.end()), summary.max);
+      double avg;
+      EXPECT_NEAR(variance(values, &avg), summary.variance, 1e-8);
+      EXPECT_NEAR(avg, summary.mean, 1e-10);
+    }
+  }
+  h.clear();
+  EXPECT_EQ(0, h.getAggregates().count);
+}
+
+// Check that all values are aggregated while logging and after replay.
+TEST(historyAggregates, loggingAndReplay)
+{
+  History h(0.5);
+  h.pushValue(0., 10.);
+  h.enableAggregates();
+  h.startLogging();
+  for (int i = 1; i <= 100; i++)
+  {
+    h.pushValue(i * 0.1, i);
+  }
+  HistoryAggregates::Summary summary = h.getAggregates();
+  EXPECT_EQ(101, summary.count);
+  EXPECT_DOUBLE_EQ(1., summary.min);
+  EXPECT_DOUBLE_EQ(100., summary.max);
+
+  std::stringstream ss;
+  h.stopLogging(ss, true);
+  History replay;
+  replay.enableAggregates();
+  replay.loadReplay(ss, true);
+  summary = replay.getAggregates();
+  EXPECT_EQ(101, summary.count);
+  EXPECT_NEAR((5050. + 10.) / 101., summary.mean, 1e-12);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <starkit_utils/history/history_codec.h>
+#include <starkit_utils/history/history.h>
+
+#include <cmath>
+#include <random>
+#include <sstream>
+
+using namespace starkit_utils;
+
+// Build a fixed rate sensor signal
+static std::deque<HistoryCodec::TimedValue> sensorSignal(size_t nbPoints)
+{
+  std::deque<HistoryCodec::TimedValue> values;
+  for (size_t i = 0; i < nbPoints; i++)
+  {
+    // Quantized encoder like values
+    values.push_back({ 12.5 + i * 0.001, std::round(1000 * std::sin(i * 0.0005)) / 1000 });
+  }
+  return values;
+}
+
+// Check that encoding is lossless for arbitrary values.
+TEST(historyCodec, roundTrip)
+{
+  std::default_random_engine engine(42);
+  std::uniform_real_distribution<double> dist(-1e6, 1e6);
+  std::deque<HistoryCodec::TimedValue> values;
+  double t = -3.;
+  for (int i = 0; i < 5000; i++)
+  {
+    t += std::abs(dist(engine)) * 1e-9 + 1e-6;
+    values.push_back({ t, i % 7 == 1 ? values.back().second : dist(engine) });
+  }
+  values.push_back({ t + 1, NAN });
+  values.push_back({ t + 2, 0. });
+  std::ostringstream os;
+  HistoryCodec::encode(values, os, 100);
+  std::istringstream is{ os.str() };
+  std::vector<HistoryCodec::TimedValue> decoded = HistoryCodec::decode(is, 4);
+  ASSERT_EQ(values.size(), decoded.size());
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    EXPECT_EQ(values[i].first, decoded[i].first);
+    if (std::isnan(values[i].second))
+    {
+      EXPECT_TRUE(std::isnan(decoded[i].second));
+    }
+    else
+    {
+      EXPECT_EQ(values[i].second, decoded[i].second);
+    }
+  }
+}
+
+// Check that fixed rate data is compressed.
+TEST(historyCodec, compression)
+{
+  std::deque<HistoryCodec::TimedValue> values = sensorSignal(100000);
+  std::ostringstream os;
+  HistoryCodec::encode(values, os);
+  size_t rawSize = sizeof(size_t) + values.size() * 2 * sizeof(double);
+  std::cout << "compression ratio: " << double(rawSize) / os.str().size() << std::endl;
+  EXPECT_LT(os.str().size() * 3, rawSize);
+
+  // Streaming decoding gives the same points
+  std::istringstream is{ os.str() };
+  HistoryCodec::Reader reader(is);
+  std::vector<HistoryCodec::TimedValue> points;
+  size_t index = 0;
+  while (reader.nextBlock(points))
+  {
+    for (const auto& point : points)
+    {
+      EXPECT_EQ(values[index], point);
+      index++;
+    }
+  }
+  EXPECT_EQ(values.size(), index);
+}
+
+// Check that History detects compressed logs whatever the binary flag.
+TEST(historyCodec, loadReplay)
+{
+  History h1(100.);
+  h1.startLogging();
+  for (const auto& point : sensorSignal(3000))
+  {
+    h1.pushValue(point.first, point.second);
+  }
+  std::ostringstream log;
+  h1.stopLogging(log, History::Compressed);
+  for (bool binary : { false, true })
+  {
+    History h2;
+    std::istringstream is{ log.str() };
+    h2.loadReplay(is, binary, 1.0);
+    EXPECT_EQ(3000, h2.size());
+    EXPECT_DOUBLE_EQ(13.5, h2.front().first);
+    EXPECT_DOUBLE_EQ(h1.back().second, h2.back().second);
+  }
+  // Truncated logs are rejected
+  History h3;
+  std::istringstream is{ log.str().substr(0, log.str().size() / 2) };
+  EXPECT_THROW(h3.loadReplay(is, true), std::runtime_error);
+}
+
+// Check that the block index is read from the trailer or rebuilt when
+// the trailer is missing.
+TEST(historyCodec, index)
+{
+  std::deque<HistoryCodec::TimedValue> values = sensorSignal(10000);
+  std::ostringstream os;
+  HistoryCodec::encode(values, os, 1000);
+  std::string log = os.str();
+  size_t indexSize = sizeof(uint64_t) + 10 * sizeof(HistoryCodec::IndexEntry) + sizeof(uint64_t) + 8;
+  for (const std::string& content : { log, log.substr(0, log.size() - indexSize) })
+  {
+    std::istringstream is{ content };
+    std::vector<HistoryCodec::IndexEntry> index = HistoryCodec::readIndex(is);
+    ASSERT_EQ(10, index.size());
+    EXPECT_EQ(8, index[0].offset);
+    EXPECT_DOUBLE_EQ(values[3000].first, index[3].firstTimestamp);
+    EXPECT_DOUBLE_EQ(values[3999].first, index[3].lastTimestamp);
+
+    std::istringstream rangeIs{ content };
+    std::vector<HistoryCodec::TimedValue> range = HistoryCodec::decodeRange(rangeIs, values[2500].first,
+                                                                            values[5500].first);
+    ASSERT_EQ(3001, range.size());
+    EXPECT_EQ(values[2500], range.front());
+    EXPECT_EQ(values[5500], range.back());
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <starkit_utils/history/history_collection.h>
+
+#include <thread>
+
+using namespace starkit_utils;
+
+// Check channels declaration.
+TEST(historyCollection, channels)
+{
+  HistoryCollection c;
+  EXPECT_EQ(0, c.addChannel("x"));
+  EXPECT_EQ(1, c.addChannel("theta", History::AngleRad));
+  EXPECT_EQ(2, c.nbChannels());
+  EXPECT_EQ(1, c.getChannelIndex("theta"));
+  EXPECT_EQ("x", c.getChannelName(0));
+  EXPECT_THROW(c.addChannel("x"), std::logic_error);
+  EXPECT_THROW(c.getChannelIndex("y"), std::out_of_range);
+  c.pushValues(1., { 2., 3. });
+  EXPECT_THROW(c.addChannel("y"), std::logic_error);
+  EXPECT_THROW(c.pushValues(2., { 2. }), std::logic_error);
+}
+
+// Check that all channels are interpolated as independent histories.
+TEST(historyCollection, interpolateAll)
+{
+  HistoryCollection c(8.);
+  History x(8.), theta(8.);
+  c.addChannel("x");
+  c.addChannel("theta", History::AngleRad);
+  std::vector<double> out;
+  c.interpolateAll(1., out);
+  EXPECT_EQ(std::vector<double>({ 0., 0. }), out);
+  for (double t : { 1., 3., 5. })
+  {
+    c.pushValues(t, { 2 * t, t * t / 2 });
+    x.pushValue(t, 2 * t);
+    theta.pushValue(t, t * t / 2);
+  }
+  for (double t : { 0., 1., 2., 2.5, 3.5, 4., 4.5, 6. })
+  {
+    c.interpolateAll(t, out);
+    EXPECT_NEAR(x.interpolate(t), out[0], 1e-12);
+    EXPECT_NEAR(theta.interpolate(t, History::AngleRad), out[1], 1e-12);
+    EXPECT_NEAR(x.interpolate(t), c.interpolate(0, t), 1e-12);
+    EXPECT_NEAR(theta.interpolate(t, History::AngleRad), c.interpolate(1, t), 1e-12);
+  }
+}
+
+// Check timestamps handling and window.
+TEST(historyCollection, window)
+{
+  HistoryCollection c(2.);
+  c.addChannel("x");
+  for (int i = 0; i < 100; i++)
+  {
+    c.pushValues(i, { 10. * i });
+  }
+  c.pushValues(99., { 0. });
+  EXPECT_THROW(c.pushValues(98., { 0. }), std::logic_error);
+  EXPECT_EQ(3, c.size());
+  EXPECT_DOUBLE_EQ(97., c.frontTimestamp());
+  EXPECT_DOUBLE_EQ(99., c.backTimestamp());
+  EXPECT_DOUBLE_EQ(975., c.interpolate(0, 97.5));
+  c.clear();
+  EXPECT_EQ(0, c.size());
+}
+
+// Check interpolation while the rows wrap around the ring storage.
+TEST(historyCollection, wrapAround)
+{
+  HistoryCollection c(1.);
+  History x(1.);
+  c.addChannel("x");
+  c.addChannel("theta", History::AngleRad);
+  for (int i = 0; i < 1000; i++)
+  {
+    double t = i * 0.03;
+    c.pushValues(t, { std::sin(t), 0.1 * i });
+    x.pushValue(t, std::sin(t));
+    EXPECT_EQ(x.size(), c.size());
+    EXPECT_DOUBLE_EQ(x.front().first, c.frontTimestamp());
+    EXPECT_DOUBLE_EQ(t, c.backTimestamp());
+    for (double dt : { -1.2, -0.95, -0.5, -0.01, 0., 0.2 })
+    {
+      EXPECT_NEAR(x.interpolate(t + dt), c.interpolate(0, t + dt), 1e-12);
+    }
+  }
+  c.clear();
+  c.addChannel("y");
+  c.pushValues(1., { 1., 2., 3. });
+  std::vector<double> out;
+  c.interpolateAll(1., out);
+  EXPECT_EQ(std::vector<double>({ 1., 2., 3. }), out);
+}
+
+// Check that channels can be added while other threads read the collection.
+TEST(historyCollection, concurrentChannels)
+{
+  HistoryCollection c;
+  std::thread reader([&c]() {
+    std::vector<double> out;
+    for (int i = 0; i < 1000; i++)
+    {
+      c.interpolateAll(1., out);
+      EXPECT_LE(out.size(), c.nbChannels());
+      EXPECT_THROW(c.pushValues(1., std::vector<double>(200, 0.)), std::logic_error);
+    }
+  });
+  for (int i = 0; i < 100; i++)
+  {
+    c.addChannel("channel_" + std::to_string(i));
+    EXPECT_EQ("channel_" + std::to_string(i), c.getChannelName(i));
+  }
+  reader.join();
+  EXPECT_EQ(100, c.nbChannels());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <starkit_utils/history/history_loader.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+using namespace starkit_utils;
+
+// Check that the chunked parser reads the same values as loadReplay,
+// including lines spanning several chunks and comments.
+TEST(historyLoader, parseAscii)
+{
+  std::ostringstream log;
+  History h(1000.);
+  h.startLogging();
+  for (int i = 0; i < 100000; i++)
+  {
+    h.pushValue(1. + i * 0.001, std::sin(i * 0.001) * 1e5);
+  }
+  h.stopLogging(log);
+  std::string content = log.str() + "  \n# end\n5 6\n";
+  ASSERT_GT(content.size(), 2u << 20);
+
+  History expected;
+  std::istringstream expectedStream(content);
+  expected.loadReplay(expectedStream);
+  std::istringstream is(content);
+  std::vector<History::TimedValue> values = HistoryLoader::parseAscii(is);
+  std::deque<History::TimedValue> expectedValues = expected.getValues();
+  ASSERT_EQ(expectedValues.size(), values.size());
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    EXPECT_EQ(expectedValues[i], values[i]);
+  }
+
+  std::istringstream noNewline("1 2\n3 4");
+  EXPECT_EQ(2, HistoryLoader::parseAscii(noNewline).size());
+  std::istringstream invalid("1 2\n3 x\n");
+  EXPECT_THROW(HistoryLoader::parseAscii(invalid), std::runtime_error);
+}
+
+// Check loading a directory of logs in several formats.
+TEST(historyLoader, loadReplayDirectory)
+{
+  char directory[] = "/tmp/history_loader_XXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(directory));
+  std::vector<std::string> names;
+  for (int k = 0; k < 20; k++)
+  {
+    History h;
+    h.startLogging();
+    for (int i = 0; i < 1000 * (k + 1); i++)
+    {
+      h.pushValue(0.5 + i * 0.01, k + i);
+    }
+    std::string name = "channel_" + std::to_string(k);
+    std::ofstream file(std::string(directory) + "/" + name + ".log", std::ios::binary);
+    h.stopLogging(file, k % 2 == 0 ? History::Ascii : History::Compressed);
+    names.push_back(name);
+  }
+  std::ofstream(std::string(directory) + "/ignored.txt") << "1 2\n";
+
+  HistoryLoader::Histories histories = HistoryLoader::loadReplayDirectory(directory, false, 1., 4, ".log");
+  ASSERT_EQ(20, histories.size());
+  for (int k = 0; k < 20; k++)
+  {
+    const History& h = *histories.at(names[k]);
+    EXPECT_EQ(1000 * (k + 1), h.size());
+    EXPECT_DOUBLE_EQ(1.5, h.front().first);
+    EXPECT_DOUBLE_EQ(k, h.front().second);
+    EXPECT_NEAR(k + 450.5, h.interpolate(6.005), 1e-9);
+  }
+
+  std::ofstream(std::string(directory) + "/broken.log") << "1 2\n0 3\n";
+  EXPECT_THROW(HistoryLoader::loadReplayDirectory(directory, false, 0., 4, ".log"), std::runtime_error);
+  EXPECT_THROW(HistoryLoader::loadReplayDirectory(std::string(directory) + "/missing"), std::runtime_error);
+
+  std::string cleanup = std::string("rm -rf ") + directory;
+  EXPECT_EQ(0, system(cleanup.c_str()));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
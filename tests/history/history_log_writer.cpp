@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <starkit_utils/history/history_log_writer.h>
+
+#include <sstream>
+
+using namespace starkit_utils;
+
+// Check that a frozen session written asynchronously can be replayed.
+TEST(historyLogWriter, closeFrozenLog)
+{
+  HistoryLogWriter writer;
+  History h1;
+  h1.startNamedLog("session");
+  h1.pushValue(1., 2.);
+  h1.pushValue(3., 4.);
+  h1.freezeNamedLog("session");
+  std::shared_ptr<std::ostringstream> log(new std::ostringstream());
+  uint64_t ticket = h1.closeFrozenLog("session", writer, log);
+  writer.wait(ticket);
+  EXPECT_TRUE(writer.isDone(ticket));
+  EXPECT_EQ(0, writer.pendingJobs());
+  EXPECT_THROW(h1.closeFrozenLog("session", writer, log), std::logic_error);
+
+  History h2;
+  std::istringstream is{ log->str() };
+  h2.loadReplay(is, true);
+  EXPECT_EQ(2, h2.size());
+  EXPECT_DOUBLE_EQ(1., h2.front().first);
+  EXPECT_DOUBLE_EQ(4., h2.back().second);
+}
+
+// Check that asynchronous logging produces the same output as the
+// synchronous one.
+TEST(historyLogWriter, stopLogging)
+{
+  HistoryLogWriter writer;
+  for (bool binary : { false, true })
+  {
+    History h1(1.), h2(1.);
+    h1.pushValue(0.5, 0.);
+    h2.pushValue(0.5, 0.);
+    h1.startLogging();
+    h2.startLogging();
+    for (int i = 1; i < 100000; i++)
+    {
+      h1.pushValue(1. + i * 0.01, i / 3.);
+      h2.pushValue(1. + i * 0.01, i / 3.);
+    }
+    std::ostringstream syncLog;
+    h1.stopLogging(syncLog, binary);
+    std::shared_ptr<std::ostringstream> asyncLog(new std::ostringstream());
+    h2.stopLogging(writer, asyncLog, binary ? History::Binary : History::Ascii);
+    writer.flush();
+    EXPECT_EQ(syncLog.str(), asyncLog->str());
+  }
+}
+
+// Check that write failures are reported by the fence.
+TEST(historyLogWriter, failure)
+{
+  HistoryLogWriter writer;
+  std::shared_ptr<std::ostringstream> log(new std::ostringstream());
+  log->setstate(std::ios::badbit);
+  std::unique_ptr<std::deque<HistoryLogWriter::TimedValue>> values(new std::deque<HistoryLogWriter::TimedValue>());
+  values->push_back({ 1., 2. });
+  writer.push(std::move(values), log);
+  EXPECT_THROW(writer.flush(), std::runtime_error);
+  EXPECT_NO_THROW(writer.flush());
+}
+
+// Check that each failure is reported to the waiter of its job only,
+// and that tickets not issued are rejected.
+TEST(historyLogWriter, failurePerTicket)
+{
+  HistoryLogWriter writer;
+  std::shared_ptr<std::ostringstream> badLog(new std::ostringstream());
+  badLog->setstate(std::ios::badbit);
+  std::shared_ptr<std::ostringstream> goodLog(new std::ostringstream());
+  std::unique_ptr<std::deque<HistoryLogWriter::TimedValue>> values(new std::deque<HistoryLogWriter::TimedValue>());
+  values->push_back({ 1., 2. });
+  uint64_t badTicket = writer.push(std::unique_ptr<std::deque<HistoryLogWriter::TimedValue>>(
+                                       new std::deque<HistoryLogWriter::TimedValue>(*values)),
+                                   badLog);
+  uint64_t goodTicket = writer.push(std::move(values), goodLog);
+  EXPECT_NO_THROW(writer.wait(goodTicket));
+  EXPECT_THROW(writer.wait(badTicket), std::runtime_error);
+  EXPECT_NO_THROW(writer.wait(badTicket));
+  EXPECT_THROW(writer.wait(goodTicket + 1), std::logic_error);
+}
+
+// The default stream buffer rejects every character
+struct RejectingBuffer : public std::streambuf
+{
+};
+
+// Check that exceptions thrown on the writer thread are rethrown to the waiter,
+// and that unknown formats are rejected when pushing.
+TEST(historyLogWriter, exceptionPerTicket)
+{
+  RejectingBuffer rejecting;
+  HistoryLogWriter writer;
+  std::shared_ptr<std::ostream> badLog(new std::ostream(&rejecting));
+  badLog->exceptions(std::ios::badbit | std::ios::failbit);
+  std::unique_ptr<std::deque<HistoryLogWriter::TimedValue>> values(new std::deque<HistoryLogWriter::TimedValue>());
+  values->push_back({ 1., 2. });
+  EXPECT_THROW(writer.push(std::unique_ptr<std::deque<HistoryLogWriter::TimedValue>>(
+                               new std::deque<HistoryLogWriter::TimedValue>(*values)),
+                           badLog, (History::LogFormat)42),
+               std::logic_error);
+  uint64_t badTicket = writer.push(std::move(values), badLog);
+  EXPECT_THROW(writer.wait(badTicket), std::runtime_error);
+  EXPECT_NO_THROW(writer.flush());
+}
+
+// Check that the window is kept after a synchronous stopLogging.
+TEST(historyLogWriter, stopLoggingKeepsWindow)
+{
+  History h(1.);
+  h.startLogging();
+  for (int i = 0; i < 1000; i++)
+  {
+    h.pushValue(i * 0.01, i);
+  }
+  std::ostringstream log;
+  h.stopLogging(log, true);
+  EXPECT_EQ(101, h.size());
+  EXPECT_DOUBLE_EQ(9.99, h.back().first);
+  EXPECT_DOUBLE_EQ(950., h.interpolate(9.5));
+
+  History replay;
+  std::istringstream is{ log.str() };
+  replay.loadReplay(is, true);
+  EXPECT_EQ(1000, replay.size());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <starkit_utils/history/history.h>
+
+using namespace starkit_utils;
+
+// Check buckets aggregates and level selection.
+TEST(historyPyramid, levels)
+{
+  HistoryPyramid pyramid(10, 3);
+  for (int i = 0; i < 2345; i++)
+  {
+    pyramid.push(i, i % 100);
+  }
+  EXPECT_EQ(235, pyramid.count(1, 0., 3000.));
+  EXPECT_EQ(24, pyramid.count(2, 0., 3000.));
+  EXPECT_EQ(3, pyramid.count(3, 0., 3000.));
+  EXPECT_EQ(2, pyramid.count(2, 150., 250.));
+
+  std::vector<HistoryPyramid::Bucket> buckets = pyramid.query(0., 3000., 50);
+  ASSERT_EQ(24, buckets.size());
+  EXPECT_DOUBLE_EQ(0., buckets[0].tStart);
+  EXPECT_DOUBLE_EQ(99., buckets[0].tEnd);
+  EXPECT_DOUBLE_EQ(0., buckets[0].min);
+  EXPECT_DOUBLE_EQ(99., buckets[0].max);
+  EXPECT_DOUBLE_EQ(49.5, buckets[0].mean);
+  EXPECT_EQ(100, buckets[0].count);
+  // Partially filled last bucket
+  EXPECT_DOUBLE_EQ(2300., buckets.back().tStart);
+  EXPECT_DOUBLE_EQ(2344., buckets.back().tEnd);
+  EXPECT_DOUBLE_EQ(22., buckets.back().mean);
+  EXPECT_EQ(45, buckets.back().count);
+
+  // Nothing fits, coarsest level is used
+  EXPECT_EQ(3, pyramid.query(0., 3000., 1).size());
+
+  pyramid.dropBefore(1500.);
+  EXPECT_EQ(2, pyramid.count(3, 0., 3000.));
+  EXPECT_EQ(9, pyramid.count(2, 0., 3000.));
+}
+
+// Check History queries in logging mode and replay.
+TEST(historyPyramid, history)
+{
+  History h(1.);
+  h.startLogging();
+  for (int i = 0; i < 100000; i++)
+  {
+    h.pushValue(i * 0.001, i % 1000);
+  }
+  EXPECT_EQ(11, h.query(0.5, 0.51, 100).size());
+  // Raw values without pyramid
+  EXPECT_EQ(100000, h.query(0., 100., 1000).size());
+  h.enablePyramid();
+  EXPECT_EQ(11, h.query(0.5, 0.51, 100).size());
+  std::vector<HistoryPyramid::Bucket> buckets = h.query(0., 100., 500);
+  EXPECT_EQ(100, buckets.size());
+  for (const HistoryPyramid::Bucket& bucket : buckets)
+  {
+    EXPECT_DOUBLE_EQ(0., bucket.min);
+    EXPECT_DOUBLE_EQ(999., bucket.max);
+    EXPECT_NEAR(499.5, bucket.mean, 1e-9);
+  }
+
+  std::stringstream ss;
+  h.stopLogging(ss, true);
+  History replay;
+  replay.enablePyramid();
+  replay.loadReplay(ss, true);
+  EXPECT_EQ(1000, replay.query(0., 100., 1000).size());
+
+  History lockFree(1., 16);
+  EXPECT_THROW(lockFree.enablePyramid(), std::logic_error);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <starkit_utils/history/history_replayer.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace starkit_utils;
+
+// Build a replayer with 3 channels at different rates.
+static void addChannels(HistoryReplayer& replayer)
+{
+  for (int k = 0; k < 3; k++)
+  {
+    History h(100.);
+    for (int i = 0; i < 100; i++)
+    {
+      h.pushValue(i * 0.01 * (k + 1), k);
+    }
+    replayer.addChannel("channel_" + std::to_string(k), h);
+  }
+}
+
+// Check that events are merged in time order and published as fast as possible.
+TEST(historyReplayer, merge)
+{
+  HistoryReplayer replayer;
+  addChannels(replayer);
+  EXPECT_EQ(3, replayer.nbChannels());
+  EXPECT_EQ("channel_2", replayer.getChannelName(2));
+  std::vector<HistoryReplayer::Event> events;
+  replayer.addConsumer([&events](const HistoryReplayer::Event& event) { events.push_back(event); });
+
+  replayer.setSpeed(HistoryReplayer::AsFastAsPossible);
+  auto start = std::chrono::steady_clock::now();
+  replayer.run();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+  EXPECT_TRUE(replayer.isOver());
+  ASSERT_EQ(300, events.size());
+  for (size_t i = 1; i < events.size(); i++)
+  {
+    EXPECT_LE(events[i - 1].timestamp, events[i].timestamp);
+    EXPECT_DOUBLE_EQ(events[i].channel, events[i].value);
+  }
+  // Ties are published in channels order
+  EXPECT_EQ(0, events[0].channel);
+  EXPECT_EQ(1, events[1].channel);
+  EXPECT_EQ(2, events[2].channel);
+  EXPECT_DOUBLE_EQ(2.97, replayer.getTime());
+  EXPECT_NEAR(2.97, replayer.getTimeStamp().getTimeSec(), 1e-6);
+
+  // Stepping
+  events.clear();
+  replayer.rewind();
+  EXPECT_FALSE(replayer.isOver());
+  EXPECT_TRUE(replayer.step());
+  EXPECT_EQ(1, events.size());
+  EXPECT_EQ(10, replayer.stepUntil(0.05));
+  EXPECT_DOUBLE_EQ(0.05, replayer.getTime());
+  while (replayer.step())
+  {
+  }
+  EXPECT_EQ(300, events.size());
+}
+
+// Check paced replay with pause and resume from another thread.
+TEST(historyReplayer, pacing)
+{
+  HistoryReplayer replayer;
+  addChannels(replayer);
+  std::atomic<int> nbEvents(0);
+  replayer.addConsumer([&nbEvents](const HistoryReplayer::Event&) { nbEvents++; });
+  // 2.97 s of data played at 20x
+  replayer.setSpeed(20.);
+  auto start = std::chrono::steady_clock::now();
+  std::thread player([&replayer]() { replayer.run(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  replayer.pause();
+  EXPECT_TRUE(replayer.isPaused());
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  int pausedEvents = nbEvents;
+  EXPECT_GT(pausedEvents, 0);
+  EXPECT_LT(pausedEvents, 300);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(pausedEvents, nbEvents);
+  replayer.resume();
+  player.join();
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(300, nbEvents);
+  EXPECT_GT(elapsed, 2.97 / 20 + 0.05);
+
+  // Stop a slow replay
+  replayer.rewind();
+  replayer.setSpeed(0.01);
+  std::thread slowPlayer([&replayer]() { replayer.run(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  replayer.stop();
+  slowPlayer.join();
+  EXPECT_FALSE(replayer.isOver());
+}
+
+// Check that stepping during a paced replay moves its time reference.
+TEST(historyReplayer, stepWhileRunning)
+{
+  HistoryReplayer replayer;
+  History h(100.);
+  for (double t : { 0., 10., 10.1, 10.2 })
+  {
+    h.pushValue(t, t);
+  }
+  replayer.addChannel("jump", h);
+  std::atomic<int> nbEvents(0);
+  replayer.addConsumer([&nbEvents](const HistoryReplayer::Event&) { nbEvents++; });
+  auto start = std::chrono::steady_clock::now();
+  std::thread player([&replayer]() { replayer.run(); });
+  while (nbEvents == 0)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(1, replayer.stepUntil(10.));
+  // The remaining 0.2 s are played from the stepped time, not 10 s later
+  while (!replayer.isOver() && std::chrono::steady_clock::now() - start < std::chrono::seconds(3))
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  replayer.stop();
+  player.join();
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(4, nbEvents);
+  EXPECT_GT(elapsed, 0.2);
+  EXPECT_LT(elapsed, 2.);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
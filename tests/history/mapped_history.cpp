@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <starkit_utils/history/mapped_history.h>
+
+#include <cstdio>
+#include <fstream>
+
+using namespace starkit_utils;
+
+static const std::string logPath = "mapped_history_test.bin";
+
+// Write a binary log with given points, h keeps them
+static void writeLog(const std::vector<History::TimedValue>& points, History& h)
+{
+  h.startLogging();
+  for (const auto& point : points)
+  {
+    h.pushValue(point.first, point.second);
+  }
+  std::ofstream out(logPath, std::ios::binary);
+  h.stopLogging(out, true);
+}
+
+// Check that mapped logs are interpolated as loaded ones.
+TEST(mappedHistory, interpolate)
+{
+  History h(100.);
+  writeLog({ { 1., 2. }, { 3., 4. }, { 5., 12. } }, h);
+  {
+    MappedHistory mapped(logPath);
+    EXPECT_EQ(3, mapped.size());
+    EXPECT_DOUBLE_EQ(1., mapped.front().first);
+    EXPECT_DOUBLE_EQ(12., mapped.back().second);
+    EXPECT_DOUBLE_EQ(4., mapped.at(1).second);
+    EXPECT_THROW(mapped.at(3), std::out_of_range);
+    for (double t : { 0., 1., 2., 2.5, 3.5, 4., 4.5, 6. })
+    {
+      EXPECT_DOUBLE_EQ(h.interpolate(t), mapped.interpolate(t));
+      EXPECT_DOUBLE_EQ(h.interpolate(t, History::AngleRad), mapped.interpolate(t, History::AngleRad));
+    }
+  }
+  remove(logPath.c_str());
+}
+
+// Check that time shift is applied as in loadReplay.
+TEST(mappedHistory, timeShift)
+{
+  History logged;
+  writeLog({ { 1., 2. }, { 3., 4. } }, logged);
+  {
+    MappedHistory mapped(logPath, 1.0);
+    std::ifstream in(logPath, std::ios::binary);
+    History h;
+    h.loadReplay(in, true, 1.0);
+    EXPECT_DOUBLE_EQ(2., mapped.front().first);
+    EXPECT_DOUBLE_EQ(4., mapped.back().first);
+    EXPECT_DOUBLE_EQ(h.interpolate(3.), mapped.interpolate(3.));
+  }
+  remove(logPath.c_str());
+}
+
+// Check errors on missing and truncated files.
+TEST(mappedHistory, invalidFiles)
+{
+  EXPECT_THROW(MappedHistory("missing_file.bin"), std::runtime_error);
+  History logged;
+  writeLog({ { 1., 2. }, { 3., 4. } }, logged);
+  std::ifstream in(logPath, std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  std::ofstream out(logPath, std::ios::binary);
+  out.write(content.data(), content.size() - 1);
+  out.close();
+  EXPECT_THROW(MappedHistory mapped(logPath), std::runtime_error);
+  remove(logPath.c_str());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <starkit_utils/history/shared_history.h>
+
+#include <cmath>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace starkit_utils;
+
+static std::string testName()
+{
+  return "/starkit_utils_test_" + std::to_string(getpid());
+}
+
+// Check that a reader sees the values of the writer and interpolates them as History.
+TEST(sharedHistory, writerReader)
+{
+  EXPECT_THROW(SharedHistory reader(testName()), std::runtime_error);
+  SharedHistory writer(testName(), 256, 1.);
+  EXPECT_TRUE(writer.isWriter());
+  SharedHistory reader(testName().substr(1));
+  EXPECT_FALSE(reader.isWriter());
+  EXPECT_EQ(256, reader.capacity());
+  EXPECT_EQ(0, reader.size());
+  EXPECT_DOUBLE_EQ(0., reader.interpolate(1.));
+  EXPECT_THROW(reader.pushValue(1., 2.), std::logic_error);
+
+  History h(1.);
+  for (int i = 0; i < 200; i++)
+  {
+    writer.pushValue(i * 0.01, std::sin(i * 0.01));
+    h.pushValue(i * 0.01, std::sin(i * 0.01));
+  }
+  EXPECT_EQ(h.size(), reader.size());
+  EXPECT_DOUBLE_EQ(h.front().first, reader.front().first);
+  EXPECT_DOUBLE_EQ(h.back().second, reader.back().second);
+  for (double t = 0.5; t < 2.5; t += 0.013)
+  {
+    EXPECT_DOUBLE_EQ(h.interpolate(t), reader.interpolate(t));
+    EXPECT_DOUBLE_EQ(h.interpolate(t, History::AngleRad), reader.interpolate(t, History::AngleRad));
+    EXPECT_DOUBLE_EQ(h.interpolate(t, History::CatmullRom), reader.interpolate(t, History::CatmullRom));
+  }
+}
+
+// Check reading from another process while the writer is pushing.
+TEST(sharedHistory, crossProcess)
+{
+  std::string name = testName();
+  SharedHistory writer(name, 4096, 0.2);
+  writer.pushValue(0., 0.);
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0)
+  {
+    // Values are always on the line v = 2 t
+    int status = 0;
+    try
+    {
+      SharedHistory reader(name);
+      for (int i = 0; i < 200000; i++)
+      {
+        History::TimedValue back = reader.back();
+        double t = back.first - 0.01;
+        double value = reader.interpolate(t);
+        // Skip queries which went out of the window meanwhile
+        if (t > reader.front().first && std::fabs(value - 2 * t) > 1e-9)
+        {
+          status = 1;
+        }
+      }
+    }
+    catch (...)
+    {
+      status = 2;
+    }
+    // Leave without running the writer destructor
+    _exit(status);
+  }
+  for (int i = 1; i < 200000; i++)
+  {
+    writer.pushValue(i * 1e-4, 2 * i * 1e-4);
+  }
+  int status;
+  waitpid(pid, &status, 0);
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
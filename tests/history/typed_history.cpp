@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <starkit_utils/history/typed_history.h>
+
+#include <cmath>
+
+using namespace starkit_utils;
+
+// Check linear interpolation of vectors and window handling.
+TEST(typedHistory, vector)
+{
+  TypedHistory<Eigen::Vector3d> h(2.);
+  EXPECT_EQ(0, h.size());
+  EXPECT_TRUE(h.interpolate(1.).isZero());
+  for (int i = 0; i < 100; i++)
+  {
+    h.pushValue(i, Eigen::Vector3d(i, 2 * i, -i));
+  }
+  EXPECT_THROW(h.pushValue(98., Eigen::Vector3d::Zero()), std::logic_error);
+  EXPECT_EQ(3, h.size());
+  EXPECT_DOUBLE_EQ(97., h.front().first);
+  EXPECT_DOUBLE_EQ(99., h.back().first);
+  EXPECT_TRUE(h.interpolate(97.5).isApprox(Eigen::Vector3d(97.5, 195., -97.5)));
+  EXPECT_TRUE(h.interpolate(10.).isApprox(Eigen::Vector3d(97., 194., -97.)));
+  EXPECT_TRUE(h.interpolate(200.).isApprox(Eigen::Vector3d(99., 198., -99.)));
+  EXPECT_EQ(3, h.getValues().size());
+  h.clear();
+  EXPECT_EQ(0, h.size());
+}
+
+// Check spherical interpolation of quaternions.
+TEST(typedHistory, quaternion)
+{
+  TypedHistory<Eigen::Quaterniond, QuaternionInterpolator> h;
+  h.pushValue(0., Eigen::Quaterniond::Identity());
+  h.pushValue(1., Eigen::Quaterniond(Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitZ())));
+  Eigen::Quaterniond q = h.interpolate(0.5);
+  Eigen::Quaterniond expected(Eigen::AngleAxisd(M_PI / 4, Eigen::Vector3d::UnitZ()));
+  EXPECT_NEAR(1., std::fabs(q.dot(expected)), 1e-12);
+  EXPECT_NEAR(1., q.norm(), 1e-12);
+}
+
+// Check that poses orientation is interpolated on the shortest path.
+TEST(typedHistory, poses)
+{
+  TypedHistory<Eigen::Vector3d, Pose2DInterpolator> h2;
+  h2.pushValue(0., Eigen::Vector3d(0., 0., M_PI - 0.1));
+  h2.pushValue(1., Eigen::Vector3d(2., 4., -M_PI + 0.1));
+  Eigen::Vector3d pose = h2.interpolate(0.5);
+  EXPECT_NEAR(1., pose(0), 1e-12);
+  EXPECT_NEAR(2., pose(1), 1e-12);
+  EXPECT_NEAR(M_PI, std::fabs(pose(2)), 1e-12);
+
+  TypedHistory<Eigen::Isometry3d, Pose3DInterpolator> h3;
+  Eigen::Isometry3d up = Eigen::Isometry3d::Identity();
+  up.translate(Eigen::Vector3d(1., 2., 3.));
+  up.rotate(Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitX()));
+  h3.pushValue(0., Eigen::Isometry3d::Identity());
+  h3.pushValue(2., up);
+  Eigen::Isometry3d mid = h3.interpolate(1.);
+  EXPECT_TRUE(mid.translation().isApprox(Eigen::Vector3d(0.5, 1., 1.5)));
+  Eigen::AngleAxisd rotation(mid.linear());
+  EXPECT_NEAR(M_PI / 4, rotation.angle(), 1e-12);
+  EXPECT_TRUE(rotation.axis().isApprox(Eigen::Vector3d::UnitX()));
+}
+
+// Check that another interpolator can be used for a query.
+TEST(typedHistory, customInterpolator)
+{
+  TypedHistory<Eigen::Vector3d> h;
+  h.pushValue(0., Eigen::Vector3d(0., 0., 3.));
+  h.pushValue(1., Eigen::Vector3d(1., 1., -3.));
+  EXPECT_NEAR(0., h.interpolate(0.5)(2), 1e-12);
+  EXPECT_NEAR(M_PI, std::fabs(h.interpolate(0.5, Pose2DInterpolator())(2)), 0.2);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "starkit_utils/timing/bench.h"
+#include "starkit_utils/timing/benchmark.h"
+
+#include <cmath>
+#include <sstream>
+
+using namespace starkit_utils;
+
+static bench::Options quickOptions()
+{
+  bench::Options options;
+  options.warmupTime = 0.01;
+  options.sampleTime = 0.002;
+  options.nbSamples = 10;
+  return options;
+}
+
+// Samples are calibrated and summarized
+TEST(bench, run)
+{
+  double x = 1;
+  bench::Result result = bench::run("sqrt",
+                                    [&x]() {
+                                      x = std::sqrt(x + 1);
+                                      bench::DoNotOptimize(x);
+                                    },
+                                    quickOptions(), NULL);
+  EXPECT_EQ("sqrt", result.name);
+  EXPECT_EQ(10, result.samples.size());
+  EXPECT_GT(result.iterationsPerSample, 100);
+  EXPECT_GT(result.median, 0);
+  EXPECT_LT(result.median, 1e-6);
+  EXPECT_GE(result.mad, 0);
+  EXPECT_LE(result.percentile(0), result.median);
+  EXPECT_GE(result.percentile(1), result.median);
+  // Samples are sessions of a Benchmark
+  int nbIterations = 0;
+  EXPECT_TRUE(Benchmark::getStats("sqrt", NULL, &nbIterations));
+  EXPECT_EQ(10, nbIterations);
+
+  std::ostringstream csv;
+  bench::writeCSV(csv, { result });
+  std::ostringstream header;
+  Benchmark::printCSVHeader(header);
+  std::string columns = header.str();
+  EXPECT_EQ(0, csv.str().find(columns.substr(0, columns.find('\n')) + ",mad\n"));
+  EXPECT_NE(std::string::npos, csv.str().find("\n0,sqrt,unknown,"));
+
+  // A run is not significantly different from itself
+  std::istringstream before(csv.str()), after(csv.str());
+  std::vector<bench::Comparison> comparisons = bench::compare(before, after);
+  ASSERT_EQ(1, comparisons.size());
+  EXPECT_DOUBLE_EQ(1, comparisons[0].ratio);
+  EXPECT_FALSE(comparisons[0].significant);
+}
+
+// Counters are measured around the samples of each run only, including
+// inside an open benchmark
+TEST(bench, counters)
+{
+  double x = 1;
+  auto fn = [&x]() {
+    x = std::sqrt(x + 1);
+    bench::DoNotOptimize(x);
+  };
+  Benchmark::enableCounters();
+  Benchmark::open("outer");
+  bench::Result inside = bench::run("counted", fn, quickOptions(), NULL);
+  Benchmark::close("outer");
+  bench::Result first = bench::run("counted", fn, quickOptions(), NULL);
+  bench::Result second = bench::run("counted", fn, quickOptions(), NULL);
+  Benchmark::enableCounters(false);
+  PerfCounters counters;
+  for (int i = 0; i < PerfCounters::NbCounters; i++)
+  {
+    bool available = counters.isAvailable(PerfCounters::Counter(i));
+    EXPECT_EQ(available, !std::isnan(inside.counters[i]));
+    EXPECT_EQ(available, !std::isnan(second.counters[i]));
+  }
+  if (counters.isAvailable(PerfCounters::Instructions))
+  {
+    double instructions = first.counters[PerfCounters::Instructions];
+    EXPECT_GT(instructions, 0);
+    EXPECT_NEAR(instructions, second.counters[PerfCounters::Instructions], instructions / 2);
+    EXPECT_NEAR(instructions, inside.counters[PerfCounters::Instructions], instructions / 2);
+  }
+}
+
+// Changes are significant if above the threshold and the noise
+TEST(bench, compare)
+{
+  std::string header = "depth,name,father,time,iterations,p50,p90,p99,p99.9,max\n";
+  std::istringstream before(header + "0,stable,unknown,1,100,1e-08,1.1e-08,1.2e-08,1.2e-08,1.2e-08\n"
+                                     "0,noisy,unknown,1,100,1e-08,2e-08,3e-08,3e-08,3e-08\n"
+                                     "0,faster,unknown,1,100,2e-08,2.1e-08,2.2e-08,2.2e-08,2.2e-08\n"
+                                     "0,removed,unknown,1,100,1e-08,1e-08,1e-08,1e-08,1e-08\n"
+                                     "1,child,stable,1,100,1e-08,1e-08,1e-08,1e-08,1e-08\n");
+  std::istringstream after(header + "0,stable,unknown,1,100,1.5e-08,1.6e-08,1.7e-08,1.7e-08,1.7e-08\n"
+                                    "0,noisy,unknown,1,100,1.5e-08,2.5e-08,3e-08,3e-08,3e-08\n"
+                                    "0,faster,unknown,1,100,1e-08,1.1e-08,1.2e-08,1.2e-08,1.2e-08\n"
+                                    "0,added,unknown,1,100,1e-08,1e-08,1e-08,1e-08,1e-08\n");
+  std::vector<bench::Comparison> comparisons = bench::compare(before, after);
+  ASSERT_EQ(3, comparisons.size());
+  EXPECT_EQ("stable", comparisons[0].name);
+  EXPECT_TRUE(comparisons[0].regression);
+  EXPECT_NEAR(1.5, comparisons[0].ratio, 1e-9);
+  EXPECT_EQ("noisy", comparisons[1].name);
+  EXPECT_FALSE(comparisons[1].significant);
+  EXPECT_EQ("faster", comparisons[2].name);
+  EXPECT_TRUE(comparisons[2].significant);
+  EXPECT_FALSE(comparisons[2].regression);
+
+  std::ostringstream out;
+  EXPECT_EQ(1, bench::printComparisons(out, comparisons));
+  EXPECT_NE(std::string::npos, out.str().find("stable REGRESSION"));
+  EXPECT_NE(std::string::npos, out.str().find("faster improvement"));
+
+  // The MAD is used as noise when both files have it, the right tail is ignored
+  std::string madHeader = "depth,name,father,time,iterations,p50,p90,p99,p99.9,max,mad\n";
+  std::istringstream skewedBefore(madHeader + "0,skewed,unknown,1,100,1e-08,2e-08,3e-08,3e-08,3e-08,2e-10\n");
+  std::istringstream skewedAfter(madHeader + "0,skewed,unknown,1,100,1.2e-08,2.2e-08,3e-08,3e-08,3e-08,2e-10\n");
+  comparisons = bench::compare(skewedBefore, skewedAfter);
+  ASSERT_EQ(1, comparisons.size());
+  EXPECT_TRUE(comparisons[0].regression);
+  // Without the mad column, the p90 estimate hides it
+  std::istringstream plainBefore(header + "0,skewed,unknown,1,100,1e-08,2e-08,3e-08,3e-08,3e-08\n");
+  std::istringstream mixedAfter(madHeader + "0,skewed,unknown,1,100,1.2e-08,2.2e-08,3e-08,3e-08,3e-08,2e-10\n");
+  comparisons = bench::compare(plainBefore, mixedAfter);
+  ASSERT_EQ(1, comparisons.size());
+  EXPECT_FALSE(comparisons[0].significant);
+
+  std::istringstream invalid("depth,name,time\n0,a,1\n"), valid(header);
+  EXPECT_THROW(bench::compare(invalid, valid), std::runtime_error);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -146,7 +146,7 @@ TEST(BenchmarkTest, testCloseSubOrBenchmark4)
   remove(absoluteTestFilePath.c_str());
 }
 
-// should write the header of csv file : depth,name,father,time
+// should write the header of csv file : depth,name,father,time,iterations,p50,p90,p99,p99.9,max
 TEST(BenchmarkTest, testPrintHeader)
 {
   benchmarkF = new Benchmark(NULL, name);
@@ -178,6 +178,10 @@ TEST(BenchmarkTest, testPrintHeader)
   EXPECT_EQ(words.at(1), "name");
   EXPECT_EQ(words.at(2), "father");
   EXPECT_EQ(words.at(3), "time");
+  EXPECT_EQ(words.at(4), "iterations");
+  EXPECT_EQ(words.at(5), "p50");
+  EXPECT_EQ(words.at(8), "p99.9");
+  EXPECT_EQ(words.at(9), "max");
 }
 // depth=1 , benchmark without father (defaultNAmeFather="unkonwn")
 // should write information about benchmark without father (default name of father is unkown")
@@ -211,9 +215,9 @@ TEST(BenchmarkTest, testPrintCsv1)
     }
   }
 
-  EXPECT_EQ(words.at(5), "BenchmarkName");
-  EXPECT_EQ(words.at(6), "unknown");
-  EXPECT_EQ(words.at(7), "0");
+  EXPECT_EQ(words.at(11), "BenchmarkName");
+  EXPECT_EQ(words.at(12), "unknown");
+  EXPECT_EQ(words.at(13), "0");
 }
 
 // should write information about benchmark and his father
@@ -250,9 +254,9 @@ TEST(BenchmarkTest, testPrintCsv2)
     }
   }
 
-  EXPECT_EQ(words.at(5), "BenchmarkName");
-  EXPECT_EQ(words.at(6), "BenchmarkFatherName");
-  EXPECT_EQ(words.at(7), "0");
+  EXPECT_EQ(words.at(11), "BenchmarkName");
+  EXPECT_EQ(words.at(12), "BenchmarkFatherName");
+  EXPECT_EQ(words.at(13), "0");
 }
 
 // should write information about benchmark and his father and his childrens(2children child1 && child2)
@@ -294,11 +298,11 @@ TEST(BenchmarkTest, testPrintCsv3)
     }
   }
 
-  EXPECT_EQ(words.at(5), "BenchmarkName");
-  EXPECT_EQ(words.at(6), "BenchmarkFatherName");
-  EXPECT_EQ(words.at(7), "0");
-  EXPECT_EQ(words.at(9), "child1");
-  EXPECT_EQ(words.at(13), "child2");
+  EXPECT_EQ(words.at(11), "BenchmarkName");
+  EXPECT_EQ(words.at(12), "BenchmarkFatherName");
+  EXPECT_EQ(words.at(13), "0");
+  EXPECT_EQ(words.at(21), "child1");
+  EXPECT_EQ(words.at(31), "child2");
 }
 
 }  // namespace starkit_utils
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "starkit_utils/timing/benchmark.h"
+
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+using namespace starkit_utils;
+
+// Count heap allocations of the test
+static size_t nbAllocations = 0;
+
+void* operator new(size_t size)
+{
+  nbAllocations++;
+  void* ptr = malloc(size);
+  if (ptr == NULL)
+  {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+  free(ptr);
+}
+
+static void cycle(bool withVision)
+{
+  BENCH_SCOPE("cycle");
+  Benchmark::open("control");
+  Benchmark::close("control");
+  if (withVision)
+  {
+    BENCH_SCOPE("vision");
+  }
+}
+
+// Reopening a known tree does not allocate
+TEST(benchmarkArena, reuse)
+{
+  cycle(true);
+  cycle(true);
+  size_t nbNodes = Benchmark::getNbArenaNodes();
+  EXPECT_LE(3, nbNodes);
+  size_t before = nbAllocations;
+  for (int i = 0; i < 1000; i++)
+  {
+    cycle(i % 2 == 0);
+  }
+  EXPECT_EQ(before, nbAllocations);
+  EXPECT_EQ(nbNodes, Benchmark::getNbArenaNodes());
+
+  int nbIterations;
+  EXPECT_TRUE(Benchmark::getStats("cycle/vision", NULL, &nbIterations));
+  EXPECT_EQ(502, nbIterations);
+
+  // Children not opened since the tree was reused are not printed
+  Benchmark::open("cycle");
+  Benchmark::open("control");
+  Benchmark::close();
+  std::ostringstream out;
+  Benchmark::close(true, -1, out);
+  EXPECT_EQ(std::string::npos, out.str().find("vision"));
+  EXPECT_NE(std::string::npos, out.str().find("control (1 iterations"));
+  EXPECT_TRUE(Benchmark::getStats("cycle/vision", NULL, &nbIterations));
+  EXPECT_EQ(502, nbIterations);
+}
+
+// Reset nodes are reused by other trees, closeCSV does not leak
+TEST(benchmarkArena, reset)
+{
+  cycle(true);
+  size_t nbNodes = Benchmark::getNbArenaNodes();
+  Benchmark::open("open");
+  EXPECT_THROW(Benchmark::resetArena(), std::runtime_error);
+  Benchmark::close("open");
+  Benchmark::resetArena();
+  EXPECT_EQ(nbNodes + 1, Benchmark::getNbFreeArenaNodes());
+
+  for (int i = 0; i < 100; i++)
+  {
+    std::ostringstream out;
+    Benchmark::open("csv");
+    Benchmark::open("a");
+    Benchmark::close();
+    Benchmark::closeCSV(out, i == 0);
+  }
+  EXPECT_EQ(nbNodes + 1, Benchmark::getNbArenaNodes());
+  EXPECT_EQ(nbNodes - 1, Benchmark::getNbFreeArenaNodes());
+}
+
+// A reused root whose children are stale prints as a fresh one in CSV
+TEST(benchmarkArena, staleCSV)
+{
+  std::ostringstream fresh;
+  Benchmark::open("staleRoot");
+  Benchmark::closeCSV(fresh, false);
+  EXPECT_EQ(std::string::npos, fresh.str().find("unknown,staleRoot"));
+
+  Benchmark::open("staleRoot");
+  Benchmark::open("child");
+  Benchmark::close();
+  std::ostringstream withChild;
+  Benchmark::closeCSV(withChild, false);
+  EXPECT_NE(std::string::npos, withChild.str().find("unknown,staleRoot"));
+
+  Benchmark::open("staleRoot");
+  std::ostringstream reused;
+  Benchmark::closeCSV(reused, false);
+  EXPECT_EQ(std::string::npos, reused.str().find("child"));
+  EXPECT_EQ(std::string::npos, reused.str().find("unknown,staleRoot"));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "starkit_utils/timing/benchmark.h"
+
+#include <stdexcept>
+
+using namespace starkit_utils;
+
+static void step(bool fail)
+{
+  BENCH_SCOPE("step");
+  {
+    BENCH_SCOPE("inner");
+    if (fail)
+    {
+      // Left open by the exception
+      Benchmark::open("unclosed");
+      throw std::runtime_error("failure");
+    }
+  }
+}
+
+// Scopes nest, share nodes with open by name and close on unwinding
+TEST(benchmarkScope, nesting)
+{
+  Benchmark::clearRegistry();
+  {
+    BENCH_SCOPE("cycle");
+    Benchmark::open("step");
+    Benchmark::close("step");
+    for (int i = 0; i < 10; i++)
+    {
+      step(false);
+    }
+    EXPECT_THROW(step(true), std::runtime_error);
+    // The scope is active again
+    Benchmark::open("after");
+    Benchmark::close("after");
+  }
+  EXPECT_EQ(NULL, Benchmark::getActive());
+
+  int nbIterations = 0;
+  EXPECT_TRUE(Benchmark::getStats("cycle", NULL, &nbIterations));
+  EXPECT_EQ(1, nbIterations);
+  EXPECT_TRUE(Benchmark::getStats("cycle/step", NULL, &nbIterations));
+  EXPECT_EQ(12, nbIterations);
+  EXPECT_TRUE(Benchmark::getStats("cycle/step/inner", NULL, &nbIterations));
+  EXPECT_EQ(11, nbIterations);
+  EXPECT_TRUE(Benchmark::getStats("cycle/step/inner/unclosed", NULL, &nbIterations));
+  EXPECT_EQ(1, nbIterations);
+  EXPECT_TRUE(Benchmark::getStats("cycle/after", NULL, &nbIterations));
+}
+
+// Interned names are unique, a scope closed early is not closed again
+TEST(benchmarkScope, interning)
+{
+  EXPECT_EQ(Benchmark::intern("name"), Benchmark::intern(std::string("name")));
+  EXPECT_NE(Benchmark::intern("name"), Benchmark::intern("other"));
+
+  Benchmark::open("root");
+  {
+    BENCH_SCOPE("child");
+    Benchmark::closeUntil("root");
+  }
+  EXPECT_EQ(NULL, Benchmark::getActive());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
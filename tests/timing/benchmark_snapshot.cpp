@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "starkit_utils/timing/benchmark.h"
+#include "starkit_utils/timing/benchmark_snapshot_writer.h"
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+using namespace starkit_utils;
+
+static void runCycle()
+{
+  Benchmark::open("control");
+  Benchmark::open("sensors");
+  Benchmark::close("sensors");
+  Benchmark::close("control");
+}
+
+// Snapshots hold the deltas since the previous one, without closing the tree
+TEST(benchmarkSnapshot, deltas)
+{
+  std::vector<Benchmark::Snapshot> snapshots;
+  Benchmark::open("main");
+  Benchmark::startSnapshots(0.02);
+  EXPECT_TRUE(Benchmark::isSnapshotting());
+  // Measures start at the first close, here the one of sensors
+  runCycle();
+  Benchmark::popSnapshots(&snapshots);
+  EXPECT_EQ(0, snapshots.size());
+
+  auto start = std::chrono::steady_clock::now();
+  int nbCycles = 0;
+  while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(50))
+  {
+    runCycle();
+    nbCycles++;
+  }
+  Benchmark::publishSnapshot();
+  EXPECT_GE(Benchmark::popSnapshots(&snapshots), 2);
+  int nbControl = 0;
+  for (const Benchmark::Snapshot& snapshot : snapshots)
+  {
+    EXPECT_GT(snapshot.endTicks, snapshot.startTicks);
+    EXPECT_EQ(0, snapshot.nbTruncated);
+    for (const Benchmark::SnapshotEntry& entry : snapshot.entries)
+    {
+      if (*entry.name == "control")
+      {
+        EXPECT_EQ("main", *entry.fatherName);
+        EXPECT_EQ(1, entry.depth);
+        nbControl += entry.nbIterations;
+      }
+      EXPECT_NE("main", *entry.name);
+    }
+  }
+  EXPECT_EQ(nbCycles + 1, nbControl);
+  for (size_t i = 1; i < snapshots.size(); i++)
+  {
+    EXPECT_EQ(snapshots[i - 1].endTicks, snapshots[i].startTicks);
+  }
+  // Popped snapshots are forgotten
+  snapshots.clear();
+  EXPECT_EQ(0, Benchmark::popSnapshots(&snapshots));
+
+  // Full rings delay the snapshots, no time is lost
+  Benchmark::startSnapshots(1e-9, 1, 1);
+  runCycle();
+  runCycle();
+  runCycle();
+  EXPECT_GE(Benchmark::getNbDelayedSnapshots(), 1);
+  EXPECT_EQ(1, Benchmark::popSnapshots(&snapshots));
+  snapshots.clear();
+  // Published at the next close, with the delayed iterations
+  runCycle();
+  EXPECT_EQ(1, Benchmark::popSnapshots(&snapshots));
+  ASSERT_EQ(1, snapshots[0].entries.size());
+  EXPECT_EQ("control", *snapshots[0].entries[0].name);
+  EXPECT_EQ(2, snapshots[0].entries[0].nbIterations);
+  EXPECT_EQ(1, snapshots[0].nbTruncated);
+  Benchmark::stopSnapshots();
+  Benchmark::close("main");
+}
+
+// The writer formats snapshots of other threads in the background
+TEST(benchmarkSnapshot, writer)
+{
+  std::ostringstream out;
+  Benchmark::startSnapshots(0.005);
+  {
+    BenchmarkSnapshotWriter writer(out, 0.001);
+    std::thread loop([]() {
+      Benchmark::setThreadName("loop");
+      for (int i = 0; i < 5; i++)
+      {
+        Benchmark::open("tick");
+        runCycle();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        Benchmark::close("tick");
+      }
+      Benchmark::publishSnapshot();
+    });
+    loop.join();
+    auto start = std::chrono::steady_clock::now();
+    while (writer.getNbWritten() == 0 && std::chrono::steady_clock::now() - start < std::chrono::seconds(1))
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_GT(writer.getNbWritten(), 0);
+  }
+  Benchmark::stopSnapshots();
+  EXPECT_EQ(0, out.str().find("timestamp,period,thread,depth,name,father,time,iterations\n"));
+  EXPECT_NE(std::string::npos, out.str().find(",loop,0,tick,unknown,"));
+  EXPECT_NE(std::string::npos, out.str().find(",loop,2,sensors,control,"));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "starkit_utils/timing/benchmark.h"
+
+#include <algorithm>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace starkit_utils;
+
+// Run nbCycles of a small benchmark tree from the calling thread
+static void runCycles(const std::string& threadName, int nbCycles, bool withVision)
+{
+  Benchmark::setThreadName(threadName);
+  for (int i = 0; i < nbCycles; i++)
+  {
+    Benchmark::open("loop");
+    Benchmark::open("control");
+    Benchmark::close("control");
+    if (withVision)
+    {
+      Benchmark::open("vision");
+      Benchmark::close("vision");
+    }
+    Benchmark::close("loop");
+  }
+}
+
+// Trees built concurrently by several threads are merged by path
+TEST(benchmarkThreads, merge)
+{
+  Benchmark::clearRegistry();
+  std::vector<std::thread> threads;
+  for (int k = 0; k < 4; k++)
+  {
+    threads.push_back(std::thread(runCycles, "worker_" + std::to_string(k), 1000, k % 2 == 0));
+  }
+  // Open and close from the main thread meanwhile, it has its own tree
+  Benchmark::open("main");
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+  Benchmark::close("main");
+
+  int nbIterations = 0;
+  double time = 0;
+  EXPECT_TRUE(Benchmark::getStats("loop", &time, &nbIterations));
+  EXPECT_EQ(4000, nbIterations);
+  EXPECT_GT(time, 0);
+  EXPECT_TRUE(Benchmark::getStats("loop/control", NULL, &nbIterations));
+  EXPECT_EQ(4000, nbIterations);
+  EXPECT_TRUE(Benchmark::getStats("loop/vision", NULL, &nbIterations));
+  EXPECT_EQ(2000, nbIterations);
+  EXPECT_TRUE(Benchmark::getStats("main", NULL, &nbIterations));
+  EXPECT_EQ(1, nbIterations);
+  EXPECT_FALSE(Benchmark::getStats("loop/missing", NULL, NULL));
+
+  // Per thread breakdown
+  EXPECT_TRUE(Benchmark::getStats("loop/control", NULL, &nbIterations, "worker_1"));
+  EXPECT_EQ(1000, nbIterations);
+  EXPECT_FALSE(Benchmark::getStats("loop/vision", NULL, NULL, "worker_1"));
+  std::vector<std::string> names = Benchmark::getThreadNames();
+  for (int k = 0; k < 4; k++)
+  {
+    EXPECT_NE(names.end(), std::find(names.begin(), names.end(), "worker_" + std::to_string(k)));
+  }
+
+  std::ostringstream merged;
+  Benchmark::printMerged(merged);
+  EXPECT_NE(std::string::npos, merged.str().find("loop (4000 iterations, p50 "));
+  EXPECT_NE(std::string::npos, merged.str().find("p99.9 "));
+  std::ostringstream perThread;
+  Benchmark::printThreads(perThread);
+  EXPECT_NE(std::string::npos, perThread.str().find("worker_3"));
+  std::ostringstream csv;
+  Benchmark::printMergedCSV(csv, true);
+  EXPECT_EQ(0, csv.str().find("depth,name,father,time,iterations,p50,p90,p99,p99.9,max"));
+  EXPECT_NE(std::string::npos, csv.str().find(",vision,loop,"));
+
+  Benchmark::clearRegistry();
+  EXPECT_FALSE(Benchmark::getStats("loop", NULL, NULL));
+}
+
+// Collecting while threads close their roots loses no iteration
+TEST(benchmarkThreads, collectWhilePublishing)
+{
+  Benchmark::clearRegistry();
+  std::vector<std::thread> threads;
+  for (int k = 0; k < 4; k++)
+  {
+    threads.push_back(std::thread(runCycles, "busy_" + std::to_string(k), 5000, true));
+  }
+  int nbIterations = 0;
+  int lastNbIterations = 0;
+  for (int i = 0; i < 100; i++)
+  {
+    std::ostringstream merged;
+    Benchmark::printMerged(merged);
+    if (Benchmark::getStats("loop", NULL, &nbIterations))
+    {
+      EXPECT_GE(nbIterations, lastNbIterations);
+      lastNbIterations = nbIterations;
+    }
+  }
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+  EXPECT_TRUE(Benchmark::getStats("loop/vision", NULL, &nbIterations));
+  EXPECT_EQ(20000, nbIterations);
+  Benchmark::clearRegistry();
+}
+
+// Closing a benchmark opened by another thread fails
+TEST(benchmarkThreads, threadLocalCurrent)
+{
+  Benchmark::open("mainOnly");
+  std::thread other([]() { EXPECT_THROW(Benchmark::close(), std::runtime_error); });
+  other.join();
+  Benchmark::close("mainOnly");
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "starkit_utils/timing/benchmark.h"
+
+#include <json/json.h>
+
+#include <map>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace starkit_utils;
+
+static void runCycles(const std::string& threadName, int nbCycles)
+{
+  Benchmark::setThreadName(threadName);
+  for (int i = 0; i < nbCycles; i++)
+  {
+    Benchmark::open("cycle");
+    Benchmark::open("\"quoted\" step");
+    Benchmark::close();
+    Benchmark::close("cycle");
+  }
+}
+
+static Json::Value parseTrace()
+{
+  std::ostringstream out;
+  Benchmark::writeTrace(out);
+  Json::Value root;
+  Json::Reader reader;
+  EXPECT_TRUE(reader.parse(out.str(), root)) << out.str();
+  return root;
+}
+
+// Events of all threads are exported with balanced begin and end events
+TEST(benchmarkTrace, export)
+{
+  Benchmark::startTracing(1000);
+  EXPECT_TRUE(Benchmark::isTracing());
+  std::vector<std::thread> threads;
+  for (int k = 0; k < 3; k++)
+  {
+    threads.push_back(std::thread(runCycles, "tracer_" + std::to_string(k), 100));
+  }
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+  Benchmark::stopTracing();
+  // Not recorded
+  runCycles("main", 1);
+  EXPECT_EQ(0, Benchmark::getNbDroppedEvents());
+
+  Json::Value root = parseTrace();
+  const Json::Value& events = root["traceEvents"];
+  ASSERT_TRUE(events.isArray());
+  std::map<int, std::string> threadNames;
+  std::map<int, int> depths;
+  std::map<int, double> lastTimes;
+  int nbEvents = 0;
+  for (const Json::Value& event : events)
+  {
+    int tid = event["tid"].asInt();
+    std::string phase = event["ph"].asString();
+    if (phase == "M")
+    {
+      threadNames[tid] = event["args"]["name"].asString();
+      continue;
+    }
+    nbEvents++;
+    EXPECT_EQ(0, threadNames[tid].find("tracer_"));
+    EXPECT_GE(event["ts"].asDouble(), lastTimes[tid]);
+    lastTimes[tid] = event["ts"].asDouble();
+    if (phase == "B")
+    {
+      depths[tid]++;
+      EXPECT_TRUE(event["name"].asString() == "cycle" || event["name"].asString() == "\"quoted\" step");
+    }
+    else
+    {
+      EXPECT_EQ("E", phase);
+      depths[tid]--;
+    }
+    EXPECT_GE(depths[tid], 0);
+  }
+  EXPECT_EQ(3 * 100 * 4, nbEvents);
+  EXPECT_EQ(3, depths.size());
+  for (const auto& depth : depths)
+  {
+    EXPECT_EQ(0, depth.second);
+  }
+}
+
+// Full buffers drop events, starting again discards previous events
+TEST(benchmarkTrace, overflow)
+{
+  Benchmark::startTracing(10);
+  runCycles("main", 10);
+  Benchmark::stopTracing();
+  EXPECT_EQ(30, Benchmark::getNbDroppedEvents());
+  int nbEvents = 0;
+  Json::Value root = parseTrace();
+  for (const Json::Value& event : root["traceEvents"])
+  {
+    nbEvents += event["ph"].asString() != "M";
+  }
+  EXPECT_EQ(10, nbEvents);
+
+  Benchmark::startTracing(10);
+  Benchmark::stopTracing();
+  EXPECT_EQ(0, Benchmark::getNbDroppedEvents());
+  nbEvents = 0;
+  root = parseTrace();
+  for (const Json::Value& event : root["traceEvents"])
+  {
+    nbEvents += event["ph"].asString() != "M";
+  }
+  EXPECT_EQ(0, nbEvents);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -45,6 +45,10 @@ TEST(chrono, chronoReset)
 {
   Chrono c;
 
+  // Let at least one microsecond elapse
+  struct timespec req = { 0, 1000000L };
+  nanosleep(&req, (struct timespec*)NULL);
+
   EXPECT_GT(c.getTime(), 0);
   double cTime = c.getTime();
   c.reset();
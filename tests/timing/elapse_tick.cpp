@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <stdlib.h>
 #include <cmath>
+#include <sstream>
 #include "starkit_utils/timing/elapse_tick.h"
 #include "gtest/gtest_prod.h"
 using namespace starkit_utils;
@@ -122,6 +123,72 @@ TEST(ElapseTick, tickTest2)
   EXPECT_GT(elapseTick->maxTime, elapseTick->avgTime);
 }
 
+// Ticks which busy wait for a given duration
+class BusyTick : public ElapseTick
+{
+public:
+  double durationMs = 0;
+
+protected:
+  virtual bool tick(double elapsed)
+  {
+    (void)elapsed;
+    TimeStamp start = TimeStamp::now();
+    while (diffMs(start, TimeStamp::now()) < durationMs)
+    {
+    }
+    return true;
+  }
+};
+
+TEST(ElapseTick, percentilesAndDeadline)
+{
+  BusyTick busyTick;
+  busyTick.setDeadline(10.0);
+  EXPECT_DOUBLE_EQ(10.0, busyTick.getDeadline());
+  // 1 slow tick every 10, deadline is loose for scheduling noise
+  for (int i = 0; i < 50; i++)
+  {
+    busyTick.durationMs = (i % 10 == 9) ? 12.0 : 0.0;
+    busyTick.ElapseTick::tick();
+  }
+  EXPECT_EQ(50, busyTick.getTimes().count());
+  // No period before the first tick
+  EXPECT_EQ(49, busyTick.getPeriods().count());
+  EXPECT_LT(busyTick.getTimePercentile(0.5), 1.0);
+  EXPECT_GE(busyTick.getTimePercentile(0.99), 11.5);
+  EXPECT_GE(busyTick.getTimePercentile(0.999), busyTick.getTimePercentile(0.99));
+  EXPECT_LE(busyTick.getTimePercentile(0.999), busyTick.maxTime);
+  EXPECT_LT(busyTick.getPeriodPercentile(0.5), 1.0);
+  EXPECT_GE(busyTick.getPeriodPercentile(0.99), 11.5);
+  EXPECT_EQ(5, busyTick.nbMisses);
+  EXPECT_EQ(1, busyTick.longestMissStreak);
+  EXPECT_EQ(1, busyTick.missStreak);
+  EXPECT_GT(busyTick.lastMiss.getTimeMS(), 0);
+
+  // Consecutive misses
+  busyTick.durationMs = 11.0;
+  busyTick.ElapseTick::tick();
+  busyTick.ElapseTick::tick();
+  EXPECT_EQ(7, busyTick.nbMisses);
+  EXPECT_EQ(3, busyTick.longestMissStreak);
+  busyTick.durationMs = 0;
+  busyTick.ElapseTick::tick();
+  EXPECT_EQ(0, busyTick.missStreak);
+  EXPECT_EQ(3, busyTick.longestMissStreak);
+
+  std::ostringstream stats;
+  busyTick.printStats(stats);
+  EXPECT_NE(std::string::npos, stats.str().find("p99.9"));
+  EXPECT_NE(std::string::npos, stats.str().find("7 misses of 10 ms deadline, longest streak 3"));
+
+  busyTick.resetStats();
+  EXPECT_FALSE(busyTick.hasStats);
+  EXPECT_EQ(0, busyTick.nbMisses);
+  EXPECT_EQ(0, busyTick.getTimes().count());
+  EXPECT_EQ(0, busyTick.getTimePercentile(0.99));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "starkit_utils/timing/latency_histogram.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+using namespace starkit_utils;
+
+// Buckets are contiguous and their lowest value is in the bucket
+TEST(latencyHistogram, buckets)
+{
+  EXPECT_EQ(0, LatencyHistogram::bucketIndex(0));
+  EXPECT_EQ(15, LatencyHistogram::bucketIndex(15));
+  EXPECT_EQ(16, LatencyHistogram::bucketIndex(16));
+  EXPECT_EQ(LatencyHistogram::NbBuckets - 1, LatencyHistogram::bucketIndex(UINT64_MAX));
+  for (size_t i = 0; i + 1 < LatencyHistogram::NbBuckets; i++)
+  {
+    uint64_t lowest = LatencyHistogram::bucketLowest(i);
+    uint64_t next = LatencyHistogram::bucketLowest(i + 1);
+    ASSERT_EQ(i, LatencyHistogram::bucketIndex(lowest));
+    ASSERT_EQ(i, LatencyHistogram::bucketIndex(next - 1));
+    // Relative width below 1/16
+    ASSERT_LE((next - lowest) * 16, std::max<uint64_t>(lowest, 16));
+  }
+}
+
+// Percentiles are within the bucket precision of the exact ones
+TEST(latencyHistogram, percentiles)
+{
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.percentile(0.5));
+  std::vector<uint64_t> values;
+  srand(42);
+  for (int i = 0; i < 100000; i++)
+  {
+    // Mostly 1 ms with a long tail, in ns
+    uint64_t value = 1000000 + rand() % 100000;
+    if (i % 100 == 0)
+    {
+      value *= 5 + rand() % 10;
+    }
+    values.push_back(value);
+    histogram.record(value);
+  }
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ(values.size(), histogram.count());
+  EXPECT_EQ(values.front(), histogram.min());
+  EXPECT_EQ(values.back(), histogram.max());
+  for (double ratio : { 0.5, 0.9, 0.99, 0.999 })
+  {
+    double exact = values[std::ceil(ratio * values.size()) - 1];
+    EXPECT_NEAR(exact, histogram.percentile(ratio), exact / 32);
+  }
+  EXPECT_EQ(values.back(), histogram.percentile(1.0));
+
+  LatencyHistogram copy(histogram);
+  copy.merge(histogram);
+  EXPECT_EQ(2 * values.size(), copy.count());
+  EXPECT_DOUBLE_EQ(histogram.percentile(0.99), copy.percentile(0.99));
+  copy.clear();
+  EXPECT_EQ(0, copy.count());
+  copy.record(7);
+  EXPECT_EQ(7, copy.percentile(0.5));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include "starkit_utils/timing/benchmark.h"
+#include "starkit_utils/timing/perf_counters.h"
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using namespace starkit_utils;
+
+// Available counters increase, the others read 0
+TEST(perfCounters, read)
+{
+  PerfCounters counters;
+  for (int i = 0; i < PerfCounters::NbCounters; i++)
+  {
+    PerfCounters::Counter counter = PerfCounters::Counter(i);
+    std::cout << PerfCounters::getName(counter) << ": " << (counters.isAvailable(counter) ? "yes" : "no") << std::endl;
+  }
+  PerfCounters::Values start, end;
+  counters.read(start);
+  volatile double sum = 0;
+  for (int i = 0; i < 100000; i++)
+  {
+    sum = sum + std::sqrt(i);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  counters.read(end);
+  for (int i = 0; i < PerfCounters::NbCounters; i++)
+  {
+    if (counters.isAvailable(PerfCounters::Counter(i)))
+    {
+      EXPECT_GE(end[i], start[i]);
+    }
+    else
+    {
+      EXPECT_EQ(0, end[i]);
+    }
+  }
+  if (counters.isAvailable(PerfCounters::Instructions))
+  {
+    EXPECT_GT(end[PerfCounters::Instructions] - start[PerfCounters::Instructions], 100000);
+  }
+  EXPECT_THROW(PerfCounters::getName(PerfCounters::NbCounters), std::out_of_range);
+}
+
+// Benchmarks report counters where available and keep measuring time otherwise
+TEST(perfCounters, benchmark)
+{
+  Benchmark::clearRegistry();
+  Benchmark::enableCounters();
+  EXPECT_TRUE(Benchmark::areCountersEnabled());
+  for (int i = 0; i < 10; i++)
+  {
+    BENCH_SCOPE("counted");
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  int nbIterations = 0;
+  EXPECT_TRUE(Benchmark::getStats("counted", NULL, &nbIterations));
+  EXPECT_EQ(10, nbIterations);
+  std::array<double, PerfCounters::NbCounters> perIteration;
+  if (Benchmark::hasCounters())
+  {
+    PerfCounters counters;
+    ASSERT_TRUE(Benchmark::getCounterStats("counted", &perIteration));
+    for (int i = 0; i < PerfCounters::NbCounters; i++)
+    {
+      EXPECT_EQ(counters.isAvailable(PerfCounters::Counter(i)), !std::isnan(perIteration[i]));
+    }
+    if (counters.isAvailable(PerfCounters::ContextSwitches))
+    {
+      // Sleeping switches context
+      EXPECT_GE(perIteration[PerfCounters::ContextSwitches], 1);
+    }
+  }
+  else
+  {
+    EXPECT_FALSE(Benchmark::getCounterStats("counted", &perIteration));
+  }
+
+  std::ostringstream csv;
+  Benchmark::printMergedCSV(csv, true);
+  std::string header;
+  std::getline(std::istringstream(csv.str()) >> std::ws, header);
+  EXPECT_EQ("depth,name,father,time,iterations,p50,p90,p99,p99.9,max,ipc,llc_misses,branch_misses,context_switches",
+            header);
+  Benchmark::enableCounters(false);
+  std::ostringstream plain;
+  Benchmark::printMergedCSV(plain, true);
+  EXPECT_EQ(0, plain.str().find("depth,name,father,time,iterations,p50,p90,p99,p99.9,max\n"));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include "starkit_utils/timing/time_stamp.h"
+#include "starkit_utils/timing/tsc_clock.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace starkit_utils;
+
+// Ticks are monotonic and converted consistently with steady_clock
+TEST(tscClock, conversions)
+{
+  std::cout << "TSC: " << (TscClock::usesTsc() ? "yes" : "no") << ", invariant: " << TscClock::hasInvariantTsc()
+            << ", frequency: " << TscClock::getFrequency() << " Hz" << std::endl;
+  EXPECT_TRUE(!TscClock::usesTsc() || TscClock::hasInvariantTsc());
+  EXPECT_GT(TscClock::getFrequency(), 1e6);
+
+  uint64_t previous = TscClock::now();
+  for (int i = 0; i < 1000; i++)
+  {
+    uint64_t ticks = TscClock::now();
+    ASSERT_GE(ticks, previous);
+    previous = ticks;
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  uint64_t startTicks = TscClock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  uint64_t endTicks = TscClock::now();
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(end - start).count();
+  EXPECT_NEAR(elapsed, TscClock::toSeconds(endTicks - startTicks), elapsed * 0.01 + 1e-4);
+
+  // Converted time stamps lie between the surrounding steady_clock reads
+  TimeStamp stamp = TimeStamp::fromTicks(startTicks);
+  EXPECT_NEAR(0, diffMs(TimeStamp(start), stamp), 0.5);
+  EXPECT_NEAR(0, diffMs(TimeStamp(end), TimeStamp::fromTicks(endTicks)), 0.5);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}